@@ -0,0 +1,248 @@
+/*
+ *  dynamic array (cdsl)
+ */
+
+#include <stddef.h>    /* size_t, NULL */
+#include <string.h>    /* memcpy, memmove, memset */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_ALLOC, MEM_RESIZE, MEM_FREE */
+#include "array.h"
+
+
+#define MINCAP 8    /* min capacity of array allocated */
+
+#define ELEM(a, i) ((a)->elem + (i)*(a)->size)    /* address of i-th element */
+
+
+/*
+ *  dynamic array
+ *
+ *  Elements are of size bytes each and kept contiguous from elem; the first length of cap
+ *  elements are in use. The array grows by doubling its capacity, thus adding elements at the end
+ *  takes a constant time amortized.
+ */
+struct array_t {
+    unsigned char *elem;    /* elements; null if cap is 0 */
+    size_t size;            /* size of element in bytes */
+    size_t length;          /* number of elements */
+    size_t cap;             /* capacity in elements */
+};
+
+
+/*
+ *  makes the capacity of an array at least a given value
+ */
+static void grow(array_t *a, size_t n)
+{
+    size_t cap;
+
+    if (n <= a->cap)
+        return;
+
+    assert(n <= (size_t)-1 / a->size);
+    cap = (a->cap > (size_t)-1 / 2 / a->size)? n: a->cap * 2;
+    if (cap < n)
+        cap = n;
+    if (cap < MINCAP && MINCAP <= (size_t)-1 / a->size)
+        cap = MINCAP;
+    if (a->elem)
+        MEM_RESIZE(a->elem, cap*a->size);
+    else
+        a->elem = MEM_ALLOC(cap*a->size);
+    a->cap = cap;
+}
+
+
+/*
+ *  creates an empty array
+ */
+array_t *(array_new)(size_t size, size_t cap)
+{
+    array_t *a;
+
+    assert(size > 0);
+
+    MEM_NEW(a);
+    a->elem = NULL;
+    a->size = size;
+    a->length = a->cap = 0;
+    if (cap > 0)
+        grow(a, cap);
+
+    return a;
+}
+
+
+/*
+ *  destroys an array
+ */
+void (array_free)(array_t **pa)
+{
+    assert(pa);
+    assert(*pa);
+
+    MEM_FREE((*pa)->elem);
+    MEM_FREE(*pa);
+}
+
+
+/*
+ *  returns the length of an array
+ */
+size_t (array_length)(const array_t *a)
+{
+    assert(a);
+    return a->length;
+}
+
+
+/*
+ *  returns the size of an element of an array
+ */
+size_t (array_size)(const array_t *a)
+{
+    assert(a);
+    return a->size;
+}
+
+
+/*
+ *  returns the address of the i-th element
+ */
+void *(array_get)(const array_t *a, size_t i)
+{
+    assert(a);
+    assert(i < a->length);
+
+    return ELEM(a, i);
+}
+
+
+/*
+ *  replaces the i-th element with a copy of a given one
+ */
+void *(array_put)(array_t *a, size_t i, const void *elem)
+{
+    assert(a);
+    assert(i < a->length);
+    assert(elem);
+
+    return memcpy(ELEM(a, i), elem, a->size);
+}
+
+
+/*
+ *  adds an element after the last element
+ *
+ *  elem may point to an element of the array, in which case it is located again by its offset
+ *  after growing moves storage.
+ */
+void *(array_push)(array_t *a, const void *elem)
+{
+    int in;
+    size_t off = 0;
+    const unsigned char *p = elem;
+
+    assert(a);
+    assert(a->length < (size_t)-1);
+
+    if (a->length == a->cap) {
+        in = (p && a->elem && p >= a->elem && p < ELEM(a, a->length));
+        if (in)
+            off = p - a->elem;
+        grow(a, a->length+1);
+        if (in)
+            p = a->elem + off;
+    }
+    if (p)
+        memcpy(ELEM(a, a->length), p, a->size);
+    else
+        memset(ELEM(a, a->length), 0, a->size);
+
+    return ELEM(a, a->length++);
+}
+
+
+/*
+ *  removes the last element
+ */
+void (array_pop)(array_t *a, void *elem)
+{
+    assert(a);
+    assert(a->length > 0);
+
+    a->length--;
+    if (elem)
+        memcpy(elem, ELEM(a, a->length), a->size);
+}
+
+
+/*
+ *  inserts elements before the i-th element
+ */
+void *(array_insert)(array_t *a, size_t i, const void *elem, size_t n)
+{
+    assert(a);
+    assert(i <= a->length);
+    assert(n <= (size_t)-1 - a->length);
+
+    if (n == 0)
+        return (a->elem)? ELEM(a, i): NULL;
+
+    grow(a, a->length+n);
+    memmove(ELEM(a, i+n), ELEM(a, i), (a->length-i)*a->size);
+    if (elem)
+        memcpy(ELEM(a, i), elem, n*a->size);
+    else
+        memset(ELEM(a, i), 0, n*a->size);
+    a->length += n;
+
+    return ELEM(a, i);
+}
+
+
+/*
+ *  removes elements from the i-th element
+ */
+void (array_remove)(array_t *a, size_t i, size_t n)
+{
+    assert(a);
+    assert(i <= a->length);
+    assert(n <= a->length - i);
+
+    if (n == 0)
+        return;
+    memmove(ELEM(a, i), ELEM(a, i+n), (a->length-i-n)*a->size);
+    a->length -= n;
+}
+
+
+/*
+ *  makes the capacity of an array at least a given value
+ */
+void (array_reserve)(array_t *a, size_t cap)
+{
+    assert(a);
+
+    grow(a, cap);
+}
+
+
+/*
+ *  shrinks storage for an array to fit elements in it
+ */
+void (array_shrink)(array_t *a)
+{
+    assert(a);
+
+    if (a->length == 0) {
+        MEM_FREE(a->elem);
+        a->cap = 0;
+    } else if (a->length < a->cap) {
+        MEM_RESIZE(a->elem, a->length*a->size);
+        a->cap = a->length;
+    }
+}
+
+/* end of array.c */
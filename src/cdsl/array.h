@@ -0,0 +1,38 @@
+/*
+ *  dynamic array (cdsl)
+ */
+
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* dynamic array */
+typedef struct array_t array_t;
+
+
+array_t *array_new(size_t, size_t);
+void array_free(array_t **);
+size_t array_length(const array_t *);
+size_t array_size(const array_t *);
+void *array_get(const array_t *, size_t);
+void *array_put(array_t *, size_t, const void *);
+void *array_push(array_t *, const void *);
+void array_pop(array_t *, void *);
+void *array_insert(array_t *, size_t, const void *, size_t);
+void array_remove(array_t *, size_t, size_t);
+void array_reserve(array_t *, size_t);
+void array_shrink(array_t *);
+
+
+/* accesses i-th element of type type */
+#define ARRAY_AT(a, type, i) (*(type *)array_get((a), (i)))
+
+/* adds element of type type with value v */
+#define ARRAY_PUSH(a, type, v) (*(type *)array_push((a), NULL) = (v))
+
+
+#endif    /* ARRAY_H */
+
+/* end of array.h */
@@ -2,23 +2,67 @@
  *  bit-vector (cdsl)
  */
 
+#include <limits.h>    /* ULONG_MAX */
 #include <stddef.h>    /* size_t, NULL */
-#include <string.h>    /* memcpy */
+#include <string.h>    /* memcpy, memset */
 
-#include "cbl/memory.h"    /* MEM_ALLOC, MEM_NEW, MEM_FREE */
+#include "cbl/memory.h"    /* MEM_ALLOC, MEM_NEW, MEM_RESIZE, MEM_FREE */
 #include "cbl/assert.h"    /* assert with exception support */
 #include "bitv.h"
 
+#if defined(BITV_USE_SIMD) && defined(__x86_64__) && (__GNUC__ >= 8 || defined(__clang__))
+#define SIMD    /* enables kernels using SIMD instructions */
+#include <immintrin.h>
+#endif    /* BITV_USE_SIMD */
+
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define ATOMIC(p)          ((_Atomic unsigned long *)(p))
+#define FETCH_OR(p, m)     atomic_fetch_or_explicit(ATOMIC(p), (m), memory_order_acq_rel)
+#define FETCH_AND(p, m)    atomic_fetch_and_explicit(ATOMIC(p), (m), memory_order_acq_rel)
+#define LOAD(p)            atomic_load_explicit(ATOMIC(p), memory_order_acquire)
+#elif defined(__ATOMIC_ACQ_REL)    /* gcc built-ins */
+#define FETCH_OR(p, m)     __atomic_fetch_or((p), (m), __ATOMIC_ACQ_REL)
+#define FETCH_AND(p, m)    __atomic_fetch_and((p), (m), __ATOMIC_ACQ_REL)
+#define LOAD(p)            __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#else    /* no atomic operations; bitv_atomic_*() are not thread-safe */
+#define FETCH_OR(p, m)     fetchop((p), (m), 1)
+#define FETCH_AND(p, m)    fetchop((p), (m), 0)
+#define LOAD(p)            (*(p))
+#endif    /* __STDC_VERSION__ */
 
 #define BPW (8 * sizeof(unsigned long))    /* number of bits per word */
+#define BPB sizeof(unsigned long)          /* number of bytes per word */
 
 #define nword(len) (((len)+BPW-1) / BPW)    /* number of words for bit-vector of length len */
 #define nbyte(len) (((len)+8-1) / 8)        /* number of bytes for bit-vector of length len */
 
 #define BIT(set, n) (((set)->byte[(n)/8] >> ((n)%8)) & 1)    /* extracts bit from bit-vector */
 
+/* parameters for rank/select directories */
+#define RS_BLK  2048UL       /* number of bits per block */
+#define RS_SUB  512UL        /* number of bits per sub-block */
+#define RS_TOP  31           /* log2 of number of bits per top-level chunk */
+#define RS_SAMP 8192UL       /* sampling interval in bits set for selection */
+
+/* accesses block entries in rank/select directories */
+#if ULONG_MAX > 0xFFFFFFFFUL    /* entry fits in one word */
+#define RS_NW 1
+#define RS_REL(e) ((e)[0] & 0xFFFFFFFFUL)
+#define RS_SH(j)  (32 + 10*(j))
+#else    /* entry occupies two words */
+#define RS_NW 2
+#define RS_REL(e) ((e)[0])
+#define RS_SH(j)  (10*(j))
+#endif    /* ULONG_MAX */
+#define RS_CNT(e, j) (((e)[RS_NW-1] >> RS_SH(j)) & 0x3FF)
+
+/* positions of lowest and highest bits set in non-zero byte */
+#define LOWBIT(c)  (((c) & 0x0F)? low[(c) & 0x0F]: 4+low[(c) >> 4])
+#define HIGHBIT(c) (((c) >> 4)? 4+high[(c) >> 4]: high[(c) & 0x0F])
+
 /* body for work on range */
-#define range(op, fcmp, cmp)                                   \
+#define range(op, cmp, mid)                                    \
     do {                                                       \
         assert(set);                                           \
         assert(l <= h);                                        \
@@ -28,29 +72,27 @@
             {                                                  \
                 size_t i;                                      \
                 for (i = l/8 + 1; i < h/8; i++)                \
-                    set->byte[i] = fcmp 0U;                    \
-                set->byte[h/8] op##= cmp lsb[l%8];             \
+                    set->byte[i] mid;                          \
+                set->byte[h/8] op##= cmp lsb[h%8];             \
             }                                                  \
         } else                                                 \
             set->byte[l/8] op##= cmp (msb[l%8] & lsb[h%8]);    \
     } while(0)
 
 /* body for set operations */
-#define setop(eq, sn, tn, op)                               \
-    do {                                                    \
-        assert(s || t);                                     \
-        if (s == t) return (eq);                            \
-        else if (!s) return (sn);                           \
-        else if (!t) return (tn);                           \
-        else {                                              \
-            size_t i;                                       \
-            bitv_t *set;                                    \
-            assert(s->length == t->length);                 \
-            set = bitv_new(s->length);                      \
-            for (i = 0; i < nword(s->length); i++)          \
-                set->word[i] = s->word[i] op t->word[i];    \
-            return set;                                     \
-        }                                                   \
+#define setop(eq, sn, tn, k)                                                   \
+    do {                                                                       \
+        assert(s || t);                                                        \
+        if (s == t) return (eq);                                               \
+        else if (!s) return (sn);                                              \
+        else if (!t) return (tn);                                              \
+        else {                                                                 \
+            bitv_t *set;                                                       \
+            assert(s->length == t->length);                                    \
+            set = bitv_new(s->length);                                         \
+            kernel()->op[k](set->word, s->word, t->word, nword(s->length));    \
+            return set;                                                        \
+        }                                                                      \
     } while(0)
 
 
@@ -61,7 +103,7 @@ static unsigned msb[] = {
 
 /* bit masks for lsbs */
 static unsigned lsb[] = {
-    0x80, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC, 0xFE, 0xFF
+    0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF
 };
 
 /* bit mask for paddings */
@@ -69,6 +111,413 @@ static unsigned pad[] = {
     0xFF, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F
 };
 
+/* positions of lowest bits set in nibbles */
+static char low[] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+
+/* positions of highest bits set in nibbles */
+static char high[] = { 0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+
+/* numbers of bits set in nibbles */
+static char count[] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+
+/*
+ *  word kernels
+ *
+ *  Set operations, comparisons and counting bits go through a table of kernels that work on whole
+ *  words. The scalar kernels below are always available. When built with BITV_USE_SIMD defined on
+ *  x86-64 with gcc or compatible compilers, kernels using AVX2 and AVX-512 are also compiled and
+ *  selected at run time depending on what the processor supports (see kernel()).
+ *
+ *  Kernels for set operations store results into d (which may be the same as s or t) and return a
+ *  non-zero value if and only if d has been changed. Those for counting return the number of bits
+ *  set in the result of a set operation without storing it. eq() returns whether two sequences of
+ *  words are equal, and sub() returns 0 if s is not a subset of t, 1 if s equals t, and 2 if s is a
+ *  proper subset of t; both stop as soon as the answer is known.
+ */
+
+/* set operations for kernels */
+enum {
+    OP_OR,        /* union */
+    OP_AND,       /* intersection */
+    OP_ANDNOT,    /* difference */
+    OP_XOR        /* symmetric difference */
+};
+
+/* table of kernels */
+struct kernel {
+    unsigned long (*op[4])(unsigned long *, const unsigned long *, const unsigned long *, size_t);
+    size_t (*count[4])(const unsigned long *, const unsigned long *, size_t);
+    int (*eq)(const unsigned long *, const unsigned long *, size_t);
+    int (*sub)(const unsigned long *, const unsigned long *, size_t);
+};
+
+
+/*
+ *  counts the number of bits set in a word
+ */
+static size_t popcount(unsigned long w)
+{
+    size_t c = 0;
+
+    for (; w; w >>= 8)
+        c += count[w & 0x0F] + count[(w >> 4) & 0x0F];
+
+    return c;
+}
+
+
+/* defines scalar kernel for set operation */
+#define SCALAROP(name, op)                                                 \
+    static unsigned long name(unsigned long *d, const unsigned long *s,    \
+                              const unsigned long *t, size_t n)            \
+    {                                                                      \
+        size_t i;                                                          \
+        unsigned long w, c = 0;                                            \
+        for (i = 0; i < n; i++) {                                          \
+            w = s[i] op t[i];                                              \
+            c |= d[i] ^ w;                                                 \
+            d[i] = w;                                                      \
+        }                                                                  \
+        return c;                                                          \
+    }
+
+/* defines scalar kernel for counting bits set in result of set operation */
+#define SCALARCNT(name, op)                                                         \
+    static size_t name(const unsigned long *s, const unsigned long *t, size_t n)    \
+    {                                                                               \
+        size_t i, c = 0;                                                            \
+        for (i = 0; i < n; i++)                                                     \
+            c += popcount(s[i] op t[i]);                                            \
+        return c;                                                                   \
+    }
+
+SCALAROP(opor, |)
+SCALAROP(opand, &)
+SCALAROP(opandnot, & ~)
+SCALAROP(opxor, ^)
+SCALARCNT(cntor, |)
+SCALARCNT(cntand, &)
+SCALARCNT(cntandnot, & ~)
+SCALARCNT(cntxor, ^)
+
+
+/*
+ *  compares two sequences of words for equality
+ */
+static int eq(const unsigned long *s, const unsigned long *t, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        if (s[i] != t[i])
+            return 0;
+    return 1;
+}
+
+
+/*
+ *  compares two sequences of words for subset
+ */
+static int sub(const unsigned long *s, const unsigned long *t, size_t n)
+{
+    size_t i;
+    int lt = 0;
+
+    for (i = 0; i < n; i++)
+        if ((s[i] & ~t[i]) != 0)
+            return 0;
+        else if (s[i] != t[i])
+            lt = 1;
+    return 1 + lt;
+}
+
+
+/* scalar kernels */
+static struct kernel kern = {
+    { opor, opand, opandnot, opxor },
+    { cntor, cntand, cntandnot, cntxor },
+    eq,
+    sub
+};
+
+
+#ifdef SIMD
+/*
+ *  AVX2 and AVX-512 kernels
+ *
+ *  A kernel processes as many words as fit in a vector register at a time and leaves remaining
+ *  words to its scalar counterpart. Only unaligned loads and stores are used because storage for
+ *  bit-vectors is not guaranteed to be aligned to vector sizes. AVX2 has no instruction to count
+ *  bits, so bits are counted by looking up a table for nibbles with vpshufb; AVX-512 kernels for
+ *  counting require the VPOPCNTDQ extension and AVX2 ones are used without it.
+ */
+
+#define AVX2    __attribute__((target("avx2")))
+#define AVX512  __attribute__((target("avx512f")))
+#define AVX512C __attribute__((target("avx512f,avx512vpopcntdq")))
+
+#define NV2   (sizeof(__m256i) / sizeof(unsigned long))    /* number of words per AVX2 vector */
+#define NV512 (sizeof(__m512i) / sizeof(unsigned long))    /* number of words per AVX-512 vector */
+
+/* loads and stores words */
+#define ld2(p)      _mm256_loadu_si256((const __m256i *)(p))
+#define st2(p, x)   _mm256_storeu_si256((__m256i *)(p), (x))
+#define ld512(p)    _mm512_loadu_si512((const void *)(p))
+#define st512(p, x) _mm512_storeu_si512((void *)(p), (x))
+
+/* difference of vectors; andnot intrinsics complement their first operands */
+#define andnot2(x, y)   _mm256_andnot_si256((y), (x))
+#define andnot512(x, y) _mm512_andnot_si512((y), (x))
+
+/* tests if vector has no bit set */
+#define zero2(x)   _mm256_testz_si256((x), (x))
+#define zero512(x) (_mm512_test_epi64_mask((x), (x)) == 0)
+
+
+/* defines AVX2 kernel for set operation */
+#define AVX2OP(name, vop, sop)                                                  \
+    static AVX2 unsigned long name(unsigned long *d, const unsigned long *s,    \
+                                   const unsigned long *t, size_t n)            \
+    {                                                                           \
+        size_t i;                                                               \
+        __m256i w, c = _mm256_setzero_si256();                                  \
+        for (i = 0; i + NV2 <= n; i += NV2) {                                   \
+            w = vop(ld2(s+i), ld2(t+i));                                        \
+            c = _mm256_or_si256(c, _mm256_xor_si256(w, ld2(d+i)));              \
+            st2(d+i, w);                                                        \
+        }                                                                       \
+        return (!zero2(c)) | sop(d+i, s+i, t+i, n-i);                           \
+    }
+
+/* defines AVX-512 kernel for set operation */
+#define AVX512OP(name, vop, sop)                                                  \
+    static AVX512 unsigned long name(unsigned long *d, const unsigned long *s,    \
+                                     const unsigned long *t, size_t n)            \
+    {                                                                             \
+        size_t i;                                                                 \
+        __m512i w, c = _mm512_setzero_si512();                                    \
+        for (i = 0; i + NV512 <= n; i += NV512) {                                 \
+            w = vop(ld512(s+i), ld512(t+i));                                      \
+            c = _mm512_or_si512(c, _mm512_xor_si512(w, ld512(d+i)));              \
+            st512(d+i, w);                                                        \
+        }                                                                         \
+        return (!zero512(c)) | sop(d+i, s+i, t+i, n-i);                           \
+    }
+
+/* defines AVX2 kernel for counting bits set in result of set operation */
+#define AVX2CNT(name, vop, sop)                                                          \
+    static AVX2 size_t name(const unsigned long *s, const unsigned long *t, size_t n)    \
+    {                                                                                    \
+        size_t i, lane[4];                                                               \
+        __m256i c = _mm256_setzero_si256();                                              \
+        for (i = 0; i + NV2 <= n; i += NV2)                                              \
+            c = _mm256_add_epi64(c, popcount2(vop(ld2(s+i), ld2(t+i))));                 \
+        st2(lane, c);                                                                    \
+        return lane[0] + lane[1] + lane[2] + lane[3] + sop(s+i, t+i, n-i);               \
+    }
+
+/* defines AVX-512 kernel for counting bits set in result of set operation */
+#define AVX512CNT(name, vop, sop)                                                         \
+    static AVX512C size_t name(const unsigned long *s, const unsigned long *t,            \
+                               size_t n)                                                  \
+    {                                                                                     \
+        size_t i;                                                                         \
+        __m512i c = _mm512_setzero_si512();                                               \
+        for (i = 0; i + NV512 <= n; i += NV512)                                           \
+            c = _mm512_add_epi64(c, _mm512_popcnt_epi64(vop(ld512(s+i), ld512(t+i))));    \
+        return (size_t)_mm512_reduce_add_epi64(c) + sop(s+i, t+i, n-i);                   \
+    }
+
+
+/*
+ *  counts bits set in each 64-bit lane of an AVX2 vector
+ */
+static AVX2 __m256i popcount2(__m256i x)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i c;
+
+    c = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(x, mask)),
+                        _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask)));
+
+    return _mm256_sad_epu8(c, _mm256_setzero_si256());
+}
+
+AVX2OP(opor2, _mm256_or_si256, opor)
+AVX2OP(opand2, _mm256_and_si256, opand)
+AVX2OP(opandnot2, andnot2, opandnot)
+AVX2OP(opxor2, _mm256_xor_si256, opxor)
+AVX2CNT(cntor2, _mm256_or_si256, cntor)
+AVX2CNT(cntand2, _mm256_and_si256, cntand)
+AVX2CNT(cntandnot2, andnot2, cntandnot)
+AVX2CNT(cntxor2, _mm256_xor_si256, cntxor)
+
+AVX512OP(opor512, _mm512_or_si512, opor)
+AVX512OP(opand512, _mm512_and_si512, opand)
+AVX512OP(opandnot512, andnot512, opandnot)
+AVX512OP(opxor512, _mm512_xor_si512, opxor)
+AVX512CNT(cntor512, _mm512_or_si512, cntor)
+AVX512CNT(cntand512, _mm512_and_si512, cntand)
+AVX512CNT(cntandnot512, andnot512, cntandnot)
+AVX512CNT(cntxor512, _mm512_xor_si512, cntxor)
+
+
+/*
+ *  compares two sequences of words for equality with AVX2
+ */
+static AVX2 int eq2(const unsigned long *s, const unsigned long *t, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + NV2 <= n; i += NV2)
+        if (!zero2(_mm256_xor_si256(ld2(s+i), ld2(t+i))))
+            return 0;
+    return eq(s+i, t+i, n-i);
+}
+
+
+/*
+ *  compares two sequences of words for equality with AVX-512
+ */
+static AVX512 int eq512(const unsigned long *s, const unsigned long *t, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + NV512 <= n; i += NV512)
+        if (!zero512(_mm512_xor_si512(ld512(s+i), ld512(t+i))))
+            return 0;
+    return eq(s+i, t+i, n-i);
+}
+
+
+/*
+ *  compares two sequences of words for subset with AVX2
+ */
+static AVX2 int sub2(const unsigned long *s, const unsigned long *t, size_t n)
+{
+    size_t i;
+    int r;
+    __m256i x, y, ne = _mm256_setzero_si256();
+
+    for (i = 0; i + NV2 <= n; i += NV2) {
+        x = ld2(s+i);
+        y = ld2(t+i);
+        if (!zero2(andnot2(x, y)))
+            return 0;
+        ne = _mm256_or_si256(ne, _mm256_xor_si256(x, y));
+    }
+    if ((r = sub(s+i, t+i, n-i)) == 0)
+        return 0;
+    return (zero2(ne))? r: 2;
+}
+
+
+/*
+ *  compares two sequences of words for subset with AVX-512
+ */
+static AVX512 int sub512(const unsigned long *s, const unsigned long *t, size_t n)
+{
+    size_t i;
+    int r;
+    __m512i x, y, ne = _mm512_setzero_si512();
+
+    for (i = 0; i + NV512 <= n; i += NV512) {
+        x = ld512(s+i);
+        y = ld512(t+i);
+        if (!zero512(andnot512(x, y)))
+            return 0;
+        ne = _mm512_or_si512(ne, _mm512_xor_si512(x, y));
+    }
+    if ((r = sub(s+i, t+i, n-i)) == 0)
+        return 0;
+    return (zero512(ne))? r: 2;
+}
+
+
+/*
+ *  selects kernels for the processor
+ *
+ *  Selection is done once on the first call. Threads may call this at the same time (e.g., through
+ *  bitv_countpart()), thus the thread that wins state from 0 to 1 writes kern and publishes it by
+ *  setting state to 2 with release, and others wait until they see 2 with acquire. SIMD is
+ *  compiled only with gcc or compatible compilers, so their atomic built-ins are used directly.
+ */
+static const struct kernel *kernel(void)
+{
+    static int state;    /* 0: not selected, 1: being selected, 2: selected */
+    int s = 0;
+
+    if (__atomic_load_n(&state, __ATOMIC_ACQUIRE) == 2)
+        return &kern;
+    if (__atomic_compare_exchange_n(&state, &s, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            struct kernel k = {
+                { opor2, opand2, opandnot2, opxor2 },
+                { cntor2, cntand2, cntandnot2, cntxor2 },
+                eq2,
+                sub2
+            };
+            kern = k;
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            kern.op[OP_OR] = opor512;
+            kern.op[OP_AND] = opand512;
+            kern.op[OP_ANDNOT] = opandnot512;
+            kern.op[OP_XOR] = opxor512;
+            kern.eq = eq512;
+            kern.sub = sub512;
+            if (__builtin_cpu_supports("avx512vpopcntdq")) {
+                kern.count[OP_OR] = cntor512;
+                kern.count[OP_AND] = cntand512;
+                kern.count[OP_ANDNOT] = cntandnot512;
+                kern.count[OP_XOR] = cntxor512;
+            }
+        }
+        __atomic_store_n(&state, 2, __ATOMIC_RELEASE);
+    } else
+        while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) != 2)
+            continue;
+
+    return &kern;
+}
+#else    /* !SIMD */
+#define kernel() (&kern)
+#endif    /* SIMD */
+
+
+#if !(__STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)) && !defined(__ATOMIC_ACQ_REL)
+/*
+ *  applies bitwise OR or AND to a word and returns its previous value
+ */
+static unsigned long fetchop(unsigned long *p, unsigned long m, int or)
+{
+    unsigned long old = *p;
+
+    *p = (or)? old | m: old & m;
+
+    return old;
+}
+#endif    /* no atomic operations */
+
+
+/*
+ *  returns a word mask for a bit
+ *
+ *  Because bits are numbered in bytes, the position of a bit in its word depends on the byte order.
+ */
+static unsigned long wmask(size_t n)
+{
+    unsigned long m = 0;
+
+    ((unsigned char *)&m)[(n/8) % BPB] = 1U << (n%8);
+
+    return m;
+}
+
 
 /*
  *  bit-vector
@@ -77,9 +526,18 @@ static unsigned pad[] = {
  *  held in length. For table-driven approaches, byte provides access to an individual byte in
  *  words for a bit-vector. Unused padding bits or bytes are unavoidable without bit-wise storage
  *  allocation, and they should have no effect on the result because always set to zeros.
+ *
+ *  cap is the number of words allocated, which may exceed what length requires after a bit-vector
+ *  has been resized; words beyond the length are also kept zero so that growing a bit-vector within
+ *  its capacity needs no work.
+ *
+ *  A view made by bitv_view() refers to words provided by a user, which are neither resized nor
+ *  deallocated by the library.
  */
 struct bitv_t {
     size_t length;          /* length in bits for bit-vector */
+    size_t cap;             /* number of words allocated */
+    int view;               /* true if words are provided by user */
     unsigned char *byte;    /* byte-wise access to bit-vector words */
     unsigned long *word;    /* words to contain bit-vector */
 };
@@ -102,6 +560,162 @@ static bitv_t *copy(const bitv_t *t)
 }
 
 
+/*
+ *  rank/select directory
+ *
+ *  struct bitv_rs_t summarizes the number of bits set in a bit-vector in three levels. A bit-vector
+ *  is divided into blocks of RS_BLK bits, each of which has an entry in ent. An entry contains the
+ *  number of bits set before the block counted from the start of the top-level chunk (of 2^RS_TOP
+ *  bits) to which the block belongs, and the numbers of bits set in the first three sub-blocks of
+ *  RS_SUB bits in the block (the last one is not necessary). Those counts are interleaved in one or
+ *  two words depending on the width of unsigned long, so that an entry occupies 64 bits for 2048
+ *  bits and the space overhead is about 3%. top has the number of bits set before each top-level
+ *  chunk, which is necessary only for bit-vectors longer than 2^RS_TOP bits.
+ *
+ *  For selection, samp records the block that contains every RS_SAMP-th bit set, which narrows the
+ *  range of blocks to search.
+ *
+ *  A directory refers to a bit-vector without copying it, so has to be built again after any
+ *  change to the bit-vector.
+ */
+struct bitv_rs_t {
+    const bitv_t *set;      /* bit-vector for directory */
+    size_t count;           /* number of bits set in bit-vector */
+    size_t nblk;            /* number of blocks */
+    unsigned long *ent;     /* entries for blocks */
+    size_t *top;            /* numbers of bits set before top-level chunks */
+    size_t *samp;           /* blocks containing every RS_SAMP-th bit set */
+};
+
+
+/*
+ *  counts bits set in a range of words
+ */
+static size_t countw(const unsigned long *w, size_t n)
+{
+    size_t c = 0;
+
+    while (n-- > 0)
+        c += popcount(*w++);
+
+    return c;
+}
+
+
+/*
+ *  returns the number of bits set before a block
+ */
+static size_t rsbase(const bitv_rs_t *rs, size_t b)
+{
+    return rs->top[(b * RS_BLK) >> RS_TOP] + RS_REL(rs->ent + b*RS_NW);
+}
+
+
+/*
+ *  performs a set operation into an existing bit-vector
+ *
+ *  A null pointer given to s or t is considered an empty bit-vector. In such a case, the result is
+ *  either empty or the same as the other operand, thus no kernel is involved.
+ */
+static int setinto(bitv_t *set, const bitv_t *s, const bitv_t *t, int op)
+{
+    size_t i, n;
+    const bitv_t *r;
+    unsigned long c = 0;
+
+    assert(set);
+    assert(!s || s->length == set->length);
+    assert(!t || t->length == set->length);
+
+    n = nword(set->length);
+    if (s && t)
+        return (kernel()->op[op](set->word, s->word, t->word, n) != 0);
+
+    r = (op == OP_AND)? NULL: (op == OP_ANDNOT)? s: (s)? s: t;
+    if (r == set)
+        return 0;
+    else if (r) {
+        c = !kernel()->eq(set->word, r->word, n);
+        if (c)
+            memcpy(set->word, r->word, n * sizeof(*set->word));
+    } else
+        for (i = 0; i < n; i++) {
+            c |= set->word[i];
+            set->word[i] = 0;
+        }
+
+    return (c != 0);
+}
+
+
+/*
+ *  performs a set operation into an existing bit-vector with an operand of any length
+ *
+ *  Missing bits in a shorter bit-vector are considered zeros. set grows to the length of t if the
+ *  result can have bits set beyond the length of set; growth alone is not considered a change.
+ */
+static int into(bitv_t *set, const bitv_t *t, int op)
+{
+    size_t i, n, m;
+    unsigned long c;
+
+    assert(set);
+
+    if (!t || t->length == set->length)
+        return setinto(set, set, t, op);
+    if (t->length > set->length && (op == OP_OR || op == OP_XOR)) {
+        bitv_resize(set, t->length);
+        return setinto(set, set, t, op);
+    }
+
+    n = nword(set->length);
+    m = nword(t->length);
+    if (m > n)    /* bits of t beyond set meet only zeros in set */
+        m = n;
+    c = kernel()->op[op](set->word, set->word, t->word, m);
+    if (op == OP_AND)
+        for (i = m; i < n; i++) {
+            c |= set->word[i];
+            set->word[i] = 0;
+        }
+
+    return (c != 0);
+}
+
+
+/*
+ *  counts bits set in the result of a set operation
+ *
+ *  Operands may have different lengths, in which case missing bits in a shorter bit-vector are
+ *  considered zeros.
+ */
+static size_t setcount(const bitv_t *s, const bitv_t *t, int op)
+{
+    size_t n, m;
+    const bitv_t *r;
+
+    assert(s || t);
+
+    if (s && t) {
+        n = nword(s->length);
+        m = nword(t->length);
+        if (n == m)
+            return kernel()->count[op](s->word, t->word, n);
+        r = (n > m)? s: t;
+        if (op == OP_AND || (op == OP_ANDNOT && r == t))
+            r = NULL;
+        if (n > m)
+            n = m;
+        return kernel()->count[op](s->word, t->word, n) +
+               ((r)? countw(r->word+n, nword(r->length)-n): 0);
+    }
+
+    r = (op == OP_AND)? NULL: (op == OP_ANDNOT)? s: (s)? s: t;
+
+    return (r)? kernel()->count[OP_OR](r->word, r->word, nword(r->length)): 0;
+}
+
+
 /*
  *  creates a new bit-vector
  */
@@ -112,6 +726,8 @@ bitv_t *(bitv_new)(size_t len) {
     set->word = (len > 0)? MEM_CALLOC(nword(len), sizeof(unsigned long)): NULL;
     set->byte = (void *)set->word;
     set->length = len;
+    set->cap = nword(len);
+    set->view = 0;
 
     return set;
 }
@@ -124,11 +740,75 @@ void (bitv_free)(bitv_t **pset) {
     assert(pset);
     assert(*pset);
 
-    MEM_FREE((*pset)->word);
+    if (!(*pset)->view)
+        MEM_FREE((*pset)->word);
     MEM_FREE(*pset);
 }
 
 
+/*
+ *  creates a bit-vector that refers to words provided by a user
+ */
+bitv_t *(bitv_view)(void *words, size_t len)
+{
+    bitv_t *set;
+
+    assert(words || len == 0);
+
+    MEM_NEW(set);
+    set->word = (len > 0)? words: NULL;
+    set->byte = (void *)set->word;
+    set->length = len;
+    set->cap = nword(len);
+    set->view = 1;
+
+    return set;
+}
+
+
+/*
+ *  returns words of a bit-vector
+ */
+void *(bitv_words)(const bitv_t *set, size_t *pn)
+{
+    assert(set);
+
+    if (pn)
+        *pn = nword(set->length) * sizeof(*set->word);
+
+    return (set->length == 0)? NULL: set->word;    /* storage may remain after resized to 0 */
+}
+
+
+/*
+ *  changes the length of a bit-vector
+ *
+ *  Storage grows at least twice to make a sequence of growth take amortized constant time, and is
+ *  never shrunk.
+ */
+void (bitv_resize)(bitv_t *set, size_t len)
+{
+    size_t n;
+
+    assert(set);
+    assert(!set->view);
+
+    if (len < set->length)
+        bitv_clear(set, len, set->length-1);    /* keeps words beyond length zero */
+    else if (nword(len) > set->cap) {
+        n = (2*set->cap > nword(len))? 2*set->cap: nword(len);
+        if (set->word)
+            MEM_RESIZE(set->word, n * sizeof(*set->word));
+        else
+            set->word = MEM_ALLOC(n * sizeof(*set->word));
+        memset(set->word+set->cap, 0, (n-set->cap) * sizeof(*set->word));
+        set->byte = (void *)set->word;
+        set->cap = n;
+    }
+    set->length = len;
+}
+
+
 /*
  *  returns the length of a bit-vector
  */
@@ -144,17 +824,61 @@ size_t (bitv_length)(const bitv_t *set) {
  */
 size_t (bitv_count)(const bitv_t *set)
 {
-    static char count[] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    assert(set);
 
-    size_t i, c = 0;
+    return kernel()->count[OP_OR](set->word, set->word, nword(set->length));
+}
+
+
+/*
+ *  counts bits set in a part of a bit-vector
+ *
+ *  A bit-vector is divided into n parts of (almost) the same number of words so that each part can
+ *  be counted by a different thread without sharing words.
+ */
+size_t (bitv_countpart)(const bitv_t *set, size_t i, size_t n)
+{
+    size_t nw, l, h;
 
     assert(set);
+    assert(i < n);
+
+    nw = nword(set->length);
+    l = nw/n*i + ((i < nw%n)? i: nw%n);
+    h = l + nw/n + (i < nw%n);
+
+    return kernel()->count[OP_OR](set->word+l, set->word+l, h-l);
+}
+
 
-    for (i = 0; i < nbyte(set->length); i++) {
-        unsigned char ch = set->byte[i];
-        c += count[ch & 0x0F] + count[ch >> 4];
+/*
+ *  counts bits set in a range of a bit-vector
+ *
+ *  Whole words in the range are counted by the kernel, and bits at both ends are extracted by
+ *  bitv_getword() to be counted.
+ */
+size_t (bitv_countrange)(const bitv_t *set, size_t l, size_t h)
+{
+    size_t lw, hw, c = 0;
+
+    assert(set);
+    assert(l <= h);
+    assert(h < set->length);
+
+    lw = (l+BPW-1) / BPW;
+    hw = (h+1) / BPW;
+    if (lw >= hw) {    /* no whole word */
+        for (; h - l >= BPW; l += BPW)
+            c += popcount(bitv_getword(set, l, BPW));
+        return c + popcount(bitv_getword(set, l, h-l+1));
     }
 
+    c = kernel()->count[OP_OR](set->word+lw, set->word+lw, hw-lw);
+    if (l < lw*BPW)
+        c += popcount(bitv_getword(set, l, lw*BPW - l));
+    if (hw*BPW <= h)
+        c += popcount(bitv_getword(set, hw*BPW, h - hw*BPW + 1));
+
     return c;
 }
 
@@ -192,12 +916,107 @@ int (bitv_put)(bitv_t *set, size_t n, int bit)
 }
 
 
+/*
+ *  gets a bit in a bit-vector atomically
+ */
+int (bitv_atomic_get)(const bitv_t *set, size_t n)
+{
+    assert(set);
+    assert(n < set->length);
+
+    return ((LOAD(&set->word[n/BPW]) & wmask(n)) != 0);
+}
+
+
+/*
+ *  sets a bit in a bit-vector atomically
+ */
+int (bitv_atomic_testset)(bitv_t *set, size_t n)
+{
+    unsigned long m;
+
+    assert(set);
+    assert(n < set->length);
+
+    m = wmask(n);
+
+    return ((FETCH_OR(&set->word[n/BPW], m) & m) != 0);
+}
+
+
+/*
+ *  clears a bit in a bit-vector atomically
+ */
+int (bitv_atomic_clear)(bitv_t *set, size_t n)
+{
+    unsigned long m;
+
+    assert(set);
+    assert(n < set->length);
+
+    m = wmask(n);
+
+    return ((FETCH_AND(&set->word[n/BPW], ~m) & m) != 0);
+}
+
+
+/*
+ *  gets a sequence of bits from a bit-vector
+ *
+ *  Bytes covering the bits are shifted into place, so at most BPB+1 bytes are read regardless of
+ *  the byte order.
+ */
+unsigned long (bitv_getword)(const bitv_t *set, size_t n, size_t nbits)
+{
+    int sh;
+    size_t i;
+    unsigned long w = 0;
+
+    assert(set);
+    assert(nbits > 0 && nbits <= BPW);
+    assert(nbits <= set->length && n <= set->length - nbits);
+
+    for (i = n/8, sh = -(int)(n%8); sh < (int)nbits; i++, sh += 8)
+        w |= (sh < 0)? (unsigned long)set->byte[i] >> -sh: (unsigned long)set->byte[i] << sh;
+
+    return (nbits < BPW)? w & ((1UL << nbits) - 1): w;
+}
+
+
+/*
+ *  puts a sequence of bits into a bit-vector
+ */
+void (bitv_putword)(bitv_t *set, size_t n, size_t nbits, unsigned long w)
+{
+    int sh;
+    size_t i;
+    unsigned m, v;
+
+    assert(set);
+    assert(nbits > 0 && nbits <= BPW);
+    assert(nbits <= set->length && n <= set->length - nbits);
+
+    for (i = n/8, sh = -(int)(n%8); sh < (int)nbits; i++, sh += 8) {
+        if (sh < 0) {
+            m = 0xFF << -sh;
+            v = w << -sh;
+        } else {
+            m = 0xFF;
+            v = w >> sh;
+        }
+        if ((int)nbits - sh < 8)
+            m &= (1U << (nbits-sh)) - 1;
+        set->byte[i] = (set->byte[i] & ~m) | (v & m);
+    }
+}
+
+
 /*
  *  sets bits to 1 in a bit-vector
  */
 void (bitv_set)(bitv_t *set, size_t l, size_t h)
 {
-    range(|, ~, +);
+    range(|, +, = (unsigned char)0xFF);
 }
 
 
@@ -206,7 +1025,7 @@ void (bitv_set)(bitv_t *set, size_t l, size_t h)
  */
 void (bitv_clear)(bitv_t *set, size_t l, size_t h)
 {
-    range(&, +, ~);
+    range(&, ~, = 0);
 }
 
 
@@ -215,7 +1034,7 @@ void (bitv_clear)(bitv_t *set, size_t l, size_t h)
  */
 void (bitv_not)(bitv_t *set, size_t l, size_t h)
 {
-    range(^, ~, +);
+    range(^, +, ^= (unsigned char)0xFF);
 }
 
 
@@ -252,21 +1071,81 @@ void (bitv_map)(bitv_t *set, void apply(size_t, int, void *), void *cl)
 }
 
 
+/*
+ *  finds the first bit set at or after a given position
+ *
+ *  Words that have no bit set are skipped as a whole; only the bytes of the word that contains the
+ *  bit to find are inspected individually. Reading up to a word boundary never goes beyond storage
+ *  for a bit-vector, and padding bits are always zeros, so any bit found is within the length.
+ */
+size_t (bitv_next)(const bitv_t *set, size_t n)
+{
+    size_t i, w;
+    unsigned c;
+
+    assert(set);
+    assert(n <= set->length);
+
+    if (n == set->length)
+        return set->length;
+
+    i = n / 8;
+    if ((c = set->byte[i] & msb[n%8]) != 0)
+        return i*8 + LOWBIT(c);
+    for (i++; i % BPB != 0; i++)    /* up to word boundary */
+        if ((c = set->byte[i]) != 0)
+            return i*8 + LOWBIT(c);
+    for (w = i / BPB; w < nword(set->length); w++)
+        if (set->word[w] != 0)
+            for (i = w * BPB; ; i++)
+                if ((c = set->byte[i]) != 0)
+                    return i*8 + LOWBIT(c);
+
+    return set->length;
+}
+
+
+/*
+ *  finds the last bit set before a given position
+ */
+size_t (bitv_prev)(const bitv_t *set, size_t n)
+{
+    size_t i, w;
+    unsigned c;
+
+    assert(set);
+    assert(n <= set->length);
+
+    if (n == 0)
+        return set->length;
+
+    n--;
+    i = n / 8;
+    if ((c = set->byte[i] & lsb[n%8]) != 0)
+        return i*8 + HIGHBIT(c);
+    while (i % BPB != 0)    /* down to word boundary */
+        if ((c = set->byte[--i]) != 0)
+            return i*8 + HIGHBIT(c);
+    for (w = i / BPB; w-- > 0; )
+        if (set->word[w] != 0)
+            for (i = w*BPB + BPB; ; )
+                if ((c = set->byte[--i]) != 0)
+                    return i*8 + HIGHBIT(c);
+
+    return set->length;
+}
+
+
 /*
  *  compares two bit-vectors for equality
  */
 int (bitv_eq)(const bitv_t *s, const bitv_t *t)
 {
-    size_t i;
-
     assert(s);
     assert(t);
     assert(s->length == t->length);
 
-    for (i = 0; i < nword(s->length); i++)
-        if (s->word[i] != t->word[i])
-            return 0;
-    return 1;
+    return kernel()->eq(s->word, t->word, nword(s->length));
 }
 
 
@@ -275,16 +1154,11 @@ int (bitv_eq)(const bitv_t *s, const bitv_t *t)
  */
 int (bitv_leq)(const bitv_t *s, const bitv_t *t)
 {
-    size_t i;
-
     assert(s);
     assert(t);
     assert(s->length == t->length);
 
-    for (i = 0; i < nword(s->length); i++)
-        if ((s->word[i] & ~t->word[i]) != 0)
-            return 0;
-    return 1;
+    return (kernel()->sub(s->word, t->word, nword(s->length)) != 0);
 }
 
 
@@ -293,19 +1167,11 @@ int (bitv_leq)(const bitv_t *s, const bitv_t *t)
  */
 int (bitv_lt)(const bitv_t *s, const bitv_t *t)
 {
-    size_t i;
-    int lt = 0;
-
     assert(s);
     assert(t);
     assert(s->length == t->length);
 
-    for (i = 0; i < nword(s->length); i++)
-        if ((s->word[i] & ~t->word[i]) != 0)
-            return 0;
-        else if (s->word[i] != t->word[i])
-            lt = 1;
-    return lt;
+    return (kernel()->sub(s->word, t->word, nword(s->length)) == 2);
 }
 
 
@@ -314,7 +1180,7 @@ int (bitv_lt)(const bitv_t *s, const bitv_t *t)
  */
 bitv_t *(bitv_union)(const bitv_t *t, const bitv_t *s)
 {
-    setop(copy(t), copy(t), copy(s), |);
+    setop(copy(t), copy(t), copy(s), OP_OR);
 }
 
 
@@ -323,16 +1189,16 @@ bitv_t *(bitv_union)(const bitv_t *t, const bitv_t *s)
  */
 bitv_t *(bitv_inter)(const bitv_t *t, const bitv_t *s)
 {
-    setop(copy(t), bitv_new(t->length), bitv_new(s->length), &);
+    setop(copy(t), bitv_new(t->length), bitv_new(s->length), OP_AND);
 }
 
 
 /*
  *  returns a difference of two bit-vectors
  */
-bitv_t *(bitv_minus)(const bitv_t *t, const bitv_t *s)
+bitv_t *(bitv_minus)(const bitv_t *s, const bitv_t *t)
 {
-    setop(bitv_new(s->length), bitv_new(t->length), copy(s), & ~);
+    setop(bitv_new(s->length), bitv_new(t->length), copy(s), OP_ANDNOT);
 }
 
 
@@ -341,7 +1207,243 @@ bitv_t *(bitv_minus)(const bitv_t *t, const bitv_t *s)
  */
 bitv_t *(bitv_diff)(const bitv_t *t, const bitv_t *s)
 {
-    setop(bitv_new(s->length), copy(t), copy(s), ^);
+    setop(bitv_new(s->length), copy(t), copy(s), OP_XOR);
+}
+
+
+/*
+ *  makes a bit-vector a union of itself and another
+ */
+int (bitv_unioninto)(bitv_t *set, const bitv_t *t)
+{
+    return into(set, t, OP_OR);
+}
+
+
+/*
+ *  makes a bit-vector an intersection of itself and another
+ */
+int (bitv_interinto)(bitv_t *set, const bitv_t *t)
+{
+    return into(set, t, OP_AND);
+}
+
+
+/*
+ *  makes a bit-vector a difference of itself and another
+ */
+int (bitv_minusinto)(bitv_t *set, const bitv_t *t)
+{
+    return into(set, t, OP_ANDNOT);
+}
+
+
+/*
+ *  makes a bit-vector a symmetric difference of itself and another
+ */
+int (bitv_diffinto)(bitv_t *set, const bitv_t *t)
+{
+    return into(set, t, OP_XOR);
+}
+
+
+/*
+ *  stores a union of two bit-vectors into a bit-vector
+ */
+int (bitv_union3)(bitv_t *set, const bitv_t *s, const bitv_t *t)
+{
+    return setinto(set, s, t, OP_OR);
+}
+
+
+/*
+ *  stores an intersection of two bit-vectors into a bit-vector
+ */
+int (bitv_inter3)(bitv_t *set, const bitv_t *s, const bitv_t *t)
+{
+    return setinto(set, s, t, OP_AND);
+}
+
+
+/*
+ *  stores a difference of two bit-vectors into a bit-vector
+ */
+int (bitv_minus3)(bitv_t *set, const bitv_t *s, const bitv_t *t)
+{
+    return setinto(set, s, t, OP_ANDNOT);
+}
+
+
+/*
+ *  stores a symmetric difference of two bit-vectors into a bit-vector
+ */
+int (bitv_diff3)(bitv_t *set, const bitv_t *s, const bitv_t *t)
+{
+    return setinto(set, s, t, OP_XOR);
+}
+
+
+/*
+ *  counts bits set in a union of two bit-vectors
+ */
+size_t (bitv_unioncount)(const bitv_t *s, const bitv_t *t)
+{
+    return setcount(s, t, OP_OR);
+}
+
+
+/*
+ *  counts bits set in an intersection of two bit-vectors
+ */
+size_t (bitv_intercount)(const bitv_t *s, const bitv_t *t)
+{
+    return setcount(s, t, OP_AND);
+}
+
+
+/*
+ *  counts bits set in a difference of two bit-vectors
+ */
+size_t (bitv_minuscount)(const bitv_t *s, const bitv_t *t)
+{
+    return setcount(s, t, OP_ANDNOT);
+}
+
+
+/*
+ *  counts bits set in a symmetric difference of two bit-vectors
+ */
+size_t (bitv_diffcount)(const bitv_t *s, const bitv_t *t)
+{
+    return setcount(s, t, OP_XOR);
+}
+
+
+/*
+ *  builds a rank/select directory for a bit-vector
+ */
+bitv_rs_t *(bitv_rsnew)(const bitv_t *set)
+{
+    size_t b, j, n, w, c, m;
+    bitv_rs_t *rs;
+
+    assert(set);
+
+    MEM_NEW(rs);
+    rs->set = set;
+    rs->count = bitv_count(set);
+    n = nword(set->length);
+    rs->nblk = (n + RS_BLK/BPW-1) / (RS_BLK/BPW);
+    rs->ent = (rs->nblk > 0)? MEM_ALLOC(rs->nblk * RS_NW * sizeof(*rs->ent)): NULL;
+    rs->top = MEM_ALLOC(((set->length >> RS_TOP) + 1) * sizeof(*rs->top));
+    m = (rs->count + RS_SAMP-1) / RS_SAMP;
+    rs->samp = (m > 0)? MEM_ALLOC(m * sizeof(*rs->samp)): NULL;
+
+    rs->top[0] = c = m = 0;
+    for (b = 0; b < rs->nblk; b++) {
+        unsigned long *e = rs->ent + b*RS_NW;
+        if (((b * RS_BLK) & ((1UL << RS_TOP) - 1)) == 0)
+            rs->top[(b * RS_BLK) >> RS_TOP] = c;
+        e[0] = c - rs->top[(b * RS_BLK) >> RS_TOP];
+#if RS_NW > 1
+        e[1] = 0;
+#endif    /* RS_NW > 1 */
+        w = b * (RS_BLK/BPW);
+        for (j = 0; j < RS_BLK/RS_SUB && w < n; j++) {
+            size_t sc = countw(set->word + w, (n - w < RS_SUB/BPW)? n - w: RS_SUB/BPW);
+            if (j < RS_BLK/RS_SUB - 1)
+                e[RS_NW-1] |= (unsigned long)sc << RS_SH(j);
+            c += sc;
+            w += RS_SUB/BPW;
+        }
+        for (; m * RS_SAMP < c; m++)    /* samples bits set in block */
+            rs->samp[m] = b;
+    }
+
+    return rs;
+}
+
+
+/*
+ *  destroys a rank/select directory
+ */
+void (bitv_rsfree)(bitv_rs_t **prs)
+{
+    assert(prs);
+    assert(*prs);
+
+    MEM_FREE((*prs)->ent);
+    MEM_FREE((*prs)->top);
+    MEM_FREE((*prs)->samp);
+    MEM_FREE(*prs);
+}
+
+
+/*
+ *  counts bits set before a given position
+ */
+size_t (bitv_rank)(const bitv_rs_t *rs, size_t n)
+{
+    size_t b, j, w, i, c;
+    const unsigned long *e;
+
+    assert(rs);
+    assert(n <= rs->set->length);
+
+    if (n == rs->set->length)
+        return rs->count;
+
+    b = n / RS_BLK;
+    e = rs->ent + b*RS_NW;
+    c = rsbase(rs, b);
+    for (j = 0; j < (n % RS_BLK) / RS_SUB; j++)
+        c += RS_CNT(e, j);
+    w = b*(RS_BLK/BPW) + j*(RS_SUB/BPW);
+    c += countw(rs->set->word + w, n/BPW - w);
+    for (i = n/BPW * BPB; i < n/8; i++)
+        c += count[rs->set->byte[i] & 0x0F] + count[rs->set->byte[i] >> 4];
+
+    return c + popcount(rs->set->byte[i] & (lsb[n%8] >> 1));
+}
+
+
+/*
+ *  finds the position of a bit set with a given rank
+ */
+size_t (bitv_select)(const bitv_rs_t *rs, size_t k)
+{
+    size_t lo, hi, j, w, i, c;
+    const unsigned long *e;
+    unsigned ch;
+
+    assert(rs);
+
+    if (k >= rs->count)
+        return rs->set->length;
+
+    /* finds last block whose base is not greater than k */
+    lo = rs->samp[k / RS_SAMP];
+    hi = (k/RS_SAMP + 1 < (rs->count+RS_SAMP-1) / RS_SAMP)? rs->samp[k/RS_SAMP + 1]: rs->nblk-1;
+    while (lo < hi) {
+        size_t mid = hi - (hi-lo)/2;
+        if (rsbase(rs, mid) <= k)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    e = rs->ent + lo*RS_NW;
+    k -= rsbase(rs, lo);
+    for (j = 0; j < RS_BLK/RS_SUB - 1 && k >= RS_CNT(e, j); j++)
+        k -= RS_CNT(e, j);
+    for (w = lo*(RS_BLK/BPW) + j*(RS_SUB/BPW); (c = popcount(rs->set->word[w])) <= k; w++)
+        k -= c;
+    for (i = w * BPB; (c = count[rs->set->byte[i] & 0x0F] + count[rs->set->byte[i] >> 4]) <= k; i++)
+        k -= c;
+    for (ch = rs->set->byte[i]; k > 0; k--)
+        ch &= ch - 1;    /* clears lowest bit set */
+
+    return i*8 + LOWBIT(ch);
 }
 
 /* end of bitv.c */
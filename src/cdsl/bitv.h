@@ -11,18 +11,33 @@
 /* bit-vector */
 typedef struct bitv_t bitv_t;
 
+/* rank/select directory for bit-vector */
+typedef struct bitv_rs_t bitv_rs_t;
+
 
 bitv_t *bitv_new(size_t);
 void bitv_free(bitv_t **);
+bitv_t *bitv_view(void *, size_t);
+void *bitv_words(const bitv_t *, size_t *);
+void bitv_resize(bitv_t *, size_t);
 size_t bitv_length(const bitv_t *);
 size_t bitv_count(const bitv_t *);
+size_t bitv_countpart(const bitv_t *, size_t, size_t);
+size_t bitv_countrange(const bitv_t *, size_t, size_t);
 int bitv_get(const bitv_t *, size_t);
 int bitv_put(bitv_t *, size_t, int);
+int bitv_atomic_get(const bitv_t *, size_t);
+int bitv_atomic_testset(bitv_t *, size_t);
+int bitv_atomic_clear(bitv_t *, size_t);
+unsigned long bitv_getword(const bitv_t *, size_t, size_t);
+void bitv_putword(bitv_t *, size_t, size_t, unsigned long);
 void bitv_set(bitv_t *, size_t, size_t);
 void bitv_clear(bitv_t *, size_t, size_t);
 void bitv_not(bitv_t *, size_t, size_t);
 void bitv_setv(bitv_t *, unsigned char *, size_t);
 void bitv_map(bitv_t *, void (size_t, int, void *), void *);
+size_t bitv_next(const bitv_t *, size_t);
+size_t bitv_prev(const bitv_t *, size_t);
 int bitv_eq(const bitv_t *, const bitv_t *);
 int bitv_leq(const bitv_t *, const bitv_t *);
 int bitv_lt(const bitv_t *, const bitv_t *);
@@ -30,6 +45,27 @@ bitv_t *bitv_union(const bitv_t *, const bitv_t *);
 bitv_t *bitv_inter(const bitv_t *, const bitv_t *);
 bitv_t *bitv_minus(const bitv_t *, const bitv_t *);
 bitv_t *bitv_diff(const bitv_t *, const bitv_t *);
+int bitv_unioninto(bitv_t *, const bitv_t *);
+int bitv_interinto(bitv_t *, const bitv_t *);
+int bitv_minusinto(bitv_t *, const bitv_t *);
+int bitv_diffinto(bitv_t *, const bitv_t *);
+int bitv_union3(bitv_t *, const bitv_t *, const bitv_t *);
+int bitv_inter3(bitv_t *, const bitv_t *, const bitv_t *);
+int bitv_minus3(bitv_t *, const bitv_t *, const bitv_t *);
+int bitv_diff3(bitv_t *, const bitv_t *, const bitv_t *);
+size_t bitv_unioncount(const bitv_t *, const bitv_t *);
+size_t bitv_intercount(const bitv_t *, const bitv_t *);
+size_t bitv_minuscount(const bitv_t *, const bitv_t *);
+size_t bitv_diffcount(const bitv_t *, const bitv_t *);
+bitv_rs_t *bitv_rsnew(const bitv_t *);
+void bitv_rsfree(bitv_rs_t **);
+size_t bitv_rank(const bitv_rs_t *, size_t);
+size_t bitv_select(const bitv_rs_t *, size_t);
+
+
+/* iterates for each bit set in bit-vector */
+#define BITV_FOREACH_SET(pos, set) for ((pos) = bitv_next((set), 0); (pos) < bitv_length(set);    \
+                                        (pos) = bitv_next((set), (pos)+1))
 
 
 #endif    /* BITV_H */
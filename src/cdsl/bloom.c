@@ -0,0 +1,394 @@
+/*
+ *  Bloom filter (cdsl)
+ */
+
+#include <stddef.h>    /* size_t, NULL */
+#include <string.h>    /* memcpy */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_ALLOC, MEM_CALLOC, MEM_NEW, MEM_FREE */
+#include "bitv.h"
+#include "bloom.h"
+
+
+#define LN2 0.69314718055994530942    /* natural logarithm of 2 */
+
+#define MAXK   30     /* max number of hash functions */
+#define BLOCK  512    /* number of bits per block (64-byte cache line) for blocked filter */
+#define HEADER 16     /* number of bytes for header of saved filter */
+#define MAXM   4294967296.0    /* max number of bits or counters (2^32) */
+
+#define M32(x) ((x) & 0xFFFFFFFFUL)    /* truncates to 32 bits */
+
+
+/* types of Bloom filters */
+enum {
+    STANDARD,    /* bits spread over whole filter */
+    BLOCKED,     /* bits confined in one block */
+    COUNTING     /* 4-bit counters instead of bits */
+};
+
+
+/*
+ *  Bloom filter
+ *
+ *  struct bloom_t has m bits (or counters) and sets k of them for each key added. The positions are
+ *  derived from one 64-bit hash value by double hashing; the hash value is computed in two 32-bit
+ *  halves, h1 and h2, so that the same filter results on any machine and a saved filter can be
+ *  loaded anywhere. Since a position is reduced from a 32-bit value, m is at most 2^32.
+ *
+ *  For STANDARD, the i-th position is (h1 + i*h2) mod m. For BLOCKED, a block of BLOCK bits is
+ *  selected by a value mixed from h1 and h2, and positions in the block are (h1 + i*h2) mod BLOCK,
+ *  so that a test touches only one cache line. Both keep bits in a bit-vector whose byte-oriented
+ *  layout is also used for saving filters. For COUNTING, each position has a 4-bit counter that
+ *  saturates at 15 and counters are packed two per byte with the lower nibble first.
+ */
+struct bloom_t {
+    int type;                /* type of filter */
+    int k;                   /* number of hash functions */
+    size_t m;                /* number of bits or counters */
+    bitv_t *set;             /* bits for STANDARD and BLOCKED */
+    unsigned char *cnt;      /* counters for COUNTING */
+};
+
+
+/*
+ *  computes the natural logarithm of a positive number
+ *
+ *  ln() avoids a dependency on the math library; it reduces x into [1, 2) and sums the series for
+ *  2*atanh((x-1)/(x+1)), which converges fast enough there.
+ */
+static double ln(double x)
+{
+    int e = 0, i;
+    double y, y2, t, s = 0;
+
+    for (; x >= 2; x /= 2)
+        e++;
+    for (; x < 1; x *= 2)
+        e--;
+    y = (x-1) / (x+1);
+    y2 = y * y;
+    for (i = 1, t = y; i < 40; i += 2, t *= y2)
+        s += t / i;
+
+    return 2*s + e*LN2;
+}
+
+
+/*
+ *  mixes bits of a 32-bit value
+ */
+static unsigned long mix(unsigned long h)
+{
+    h = M32(h ^ (h >> 16));
+    h = M32(h * 0x85EBCA6BUL);
+    h = M32(h ^ (h >> 13));
+    h = M32(h * 0xC2B2AE35UL);
+
+    return h ^ (h >> 16);
+}
+
+
+/*
+ *  computes a 64-bit hash value of a key in two halves
+ *
+ *  h2 is forced to be odd so that double hashing visits distinct positions for a power-of-2 m.
+ */
+static void hash(const void *key, size_t len, unsigned long *h1, unsigned long *h2)
+{
+    const unsigned char *p = key;
+    unsigned long a = 0x811C9DC5UL, b = M32(0x9E3779B9UL ^ len);
+
+    while (len-- > 0) {
+        a = M32((a ^ *p) * 0x01000193UL);
+        b = M32((b ^ *p++) * 0x5BD1E995UL);
+        b ^= b >> 15;
+    }
+    *h1 = mix(a ^ (b >> 7));
+    *h2 = mix(M32(b + 0x9E3779B9UL*a)) | 1;
+}
+
+
+/*
+ *  creates a Bloom filter of a given type
+ *
+ *  The number of bits m and the number of hash functions k are chosen to minimize the false
+ *  positive rate for n keys: m = -n*ln(p) / ln(2)^2 and k = m/n * ln(2).
+ */
+static bloom_t *create(int type, size_t n, double p)
+{
+    double m;
+    bloom_t *b;
+
+    assert(n > 0);
+    assert(p > 0 && p < 1);
+
+    m = -(double)n * ln(p) / (LN2*LN2);
+    assert(m < MAXM - BLOCK && m < (double)((size_t)-1 - BLOCK));
+
+    MEM_NEW(b);
+    b->type = type;
+    b->m = (size_t)m + 1;
+    b->k = (int)(m / n * LN2 + 0.5);
+    if (b->k < 1)
+        b->k = 1;
+    else if (b->k > MAXK)
+        b->k = MAXK;
+    if (type == BLOCKED)
+        b->m = (b->m + BLOCK-1) / BLOCK * BLOCK;
+    if (type == COUNTING) {
+        b->set = NULL;
+        b->cnt = MEM_CALLOC((b->m+1) / 2, 1);
+    } else {
+        b->set = bitv_new(b->m);
+        b->cnt = NULL;
+    }
+
+    return b;
+}
+
+
+/*
+ *  returns the i-th position for a key
+ */
+static size_t pos(const bloom_t *b, unsigned long h1, unsigned long h2, int i)
+{
+    if (b->type == BLOCKED)
+        return mix(M32(h1 + 0x9E3779B9UL*h2)) % (b->m / BLOCK) * BLOCK +
+               M32(h1 + M32((unsigned long)i*h2)) % BLOCK;
+    else
+        return M32(h1 + M32((unsigned long)i*h2)) % b->m;
+}
+
+
+/*
+ *  creates a standard Bloom filter
+ */
+bloom_t *(bloom_new)(size_t n, double p)
+{
+    return create(STANDARD, n, p);
+}
+
+
+/*
+ *  creates a blocked Bloom filter
+ */
+bloom_t *(bloom_newblocked)(size_t n, double p)
+{
+    return create(BLOCKED, n, p);
+}
+
+
+/*
+ *  creates a counting Bloom filter
+ */
+bloom_t *(bloom_newcounting)(size_t n, double p)
+{
+    return create(COUNTING, n, p);
+}
+
+
+/*
+ *  destroys a Bloom filter
+ */
+void (bloom_free)(bloom_t **pb)
+{
+    assert(pb);
+    assert(*pb);
+
+    if ((*pb)->set)
+        bitv_free(&(*pb)->set);
+    MEM_FREE((*pb)->cnt);
+    MEM_FREE(*pb);
+}
+
+
+/*
+ *  adds a key to a Bloom filter
+ */
+void (bloom_add)(bloom_t *b, const void *key, size_t len)
+{
+    int i;
+    size_t x;
+    unsigned long h1, h2;
+    unsigned char *p;
+
+    assert(b);
+    assert(key || len == 0);
+
+    hash(key, len, &h1, &h2);
+    if (b->type == COUNTING)
+        for (i = 0; i < b->k; i++) {
+            x = pos(b, h1, h2, i);
+            if (((b->cnt[x/2] >> (x%2*4)) & 0x0F) < 0x0F)
+                b->cnt[x/2] += 1U << (x%2*4);
+        }
+    else {
+        p = bitv_words(b->set, NULL);
+        for (i = 0; i < b->k; i++) {
+            x = pos(b, h1, h2, i);
+            p[x/8] |= 1U << (x%8);
+        }
+    }
+}
+
+
+/*
+ *  tests if a key may have been added to a Bloom filter
+ */
+int (bloom_test)(const bloom_t *b, const void *key, size_t len)
+{
+    int i;
+    size_t x;
+    unsigned long h1, h2;
+    const unsigned char *p;
+
+    assert(b);
+    assert(key || len == 0);
+
+    hash(key, len, &h1, &h2);
+    if (b->type == COUNTING) {
+        for (i = 0; i < b->k; i++) {
+            x = pos(b, h1, h2, i);
+            if (((b->cnt[x/2] >> (x%2*4)) & 0x0F) == 0)
+                return 0;
+        }
+    } else {
+        p = bitv_words(b->set, NULL);
+        for (i = 0; i < b->k; i++) {
+            x = pos(b, h1, h2, i);
+            if (!((p[x/8] >> (x%8)) & 1))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/*
+ *  removes a key from a counting Bloom filter
+ *
+ *  A saturated counter is never decremented because the number of keys it counts is unknown.
+ */
+void (bloom_remove)(bloom_t *b, const void *key, size_t len)
+{
+    int i;
+    size_t x;
+    unsigned c;
+    unsigned long h1, h2;
+
+    assert(b);
+    assert(b->type == COUNTING);
+    assert(bloom_test(b, key, len));
+
+    hash(key, len, &h1, &h2);
+    for (i = 0; i < b->k; i++) {
+        x = pos(b, h1, h2, i);
+        c = (b->cnt[x/2] >> (x%2*4)) & 0x0F;
+        if (c > 0 && c < 0x0F)
+            b->cnt[x/2] -= 1U << (x%2*4);
+    }
+}
+
+
+/*
+ *  merges a Bloom filter into another
+ */
+void (bloom_merge)(bloom_t *b, const bloom_t *c)
+{
+    size_t i;
+    unsigned s, t;
+
+    assert(b);
+    assert(c);
+    assert(b->type == c->type && b->m == c->m && b->k == c->k);
+
+    if (b->type != COUNTING) {
+        bitv_unioninto(b->set, c->set);
+        return;
+    }
+
+    for (i = 0; i < (b->m+1) / 2; i++) {
+        s = (b->cnt[i] & 0x0F) + (c->cnt[i] & 0x0F);
+        t = (b->cnt[i] >> 4) + (c->cnt[i] >> 4);
+        b->cnt[i] = ((s > 0x0F)? 0x0F: s) | ((t > 0x0F)? 0x0F: t) << 4;
+    }
+}
+
+
+/*
+ *  saves a Bloom filter into a byte array
+ *
+ *  A saved filter starts with a header of HEADER bytes: "BLMF", the type, k, two zero bytes and m in
+ *  8 bytes with the least significant byte first. Bits or counters follow.
+ */
+void *(bloom_save)(const bloom_t *b, size_t *pn)
+{
+    int i;
+    size_t n, m;
+    unsigned char *p;
+
+    assert(b);
+    assert(pn);
+
+    n = (b->type == COUNTING)? (b->m+1) / 2: (b->m+7) / 8;
+    p = MEM_ALLOC(HEADER + n);
+    memcpy(p, "BLMF", 4);
+    p[4] = b->type;
+    p[5] = b->k;
+    p[6] = p[7] = 0;
+    for (i = 8, m = b->m; i < HEADER; i++, m >>= 8)
+        p[i] = m & 0xFF;
+    memcpy(p+HEADER, (b->cnt)? (void *)b->cnt: bitv_words(b->set, NULL), n);
+    *pn = HEADER + n;
+
+    return p;
+}
+
+
+/*
+ *  loads a Bloom filter from a byte array
+ */
+bloom_t *(bloom_load)(const void *buf, size_t n)
+{
+    int i;
+    size_t m, nb;
+    bloom_t *b;
+    const unsigned char *p = buf;
+
+    assert(buf);
+
+    if (n < HEADER || memcmp(p, "BLMF", 4) != 0 || p[4] > COUNTING || p[5] < 1 || p[5] > MAXK ||
+        p[6] != 0 || p[7] != 0)
+        return NULL;
+    for (i = HEADER-1, m = 0; i >= 8; i--) {
+        if (m > ((size_t)-1 >> 8))
+            return NULL;
+        m = (m << 8) | p[i];
+    }
+    if (m == 0 || m > MAXM || (p[4] == BLOCKED && m % BLOCK != 0))
+        return NULL;
+    nb = (p[4] == COUNTING)? m/2 + m%2: m/8 + (m%8 != 0);
+    if (n - HEADER != nb || (p[4] != COUNTING && m%8 && (p[HEADER+nb-1] >> (m%8))))
+        return NULL;
+
+    MEM_NEW(b);
+    b->type = p[4];
+    b->k = p[5];
+    b->m = m;
+    if (b->type == COUNTING) {
+        b->set = NULL;
+        b->cnt = MEM_ALLOC(nb);
+        memcpy(b->cnt, p+HEADER, nb);
+    } else {
+        b->set = bitv_new(m);
+        b->cnt = NULL;
+        memcpy(bitv_words(b->set, NULL), p+HEADER, nb);
+    }
+
+    return b;
+}
+
+/* end of bloom.c */
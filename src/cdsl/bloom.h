@@ -0,0 +1,29 @@
+/*
+ *  Bloom filter (cdsl)
+ */
+
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* Bloom filter */
+typedef struct bloom_t bloom_t;
+
+
+bloom_t *bloom_new(size_t, double);
+bloom_t *bloom_newblocked(size_t, double);
+bloom_t *bloom_newcounting(size_t, double);
+void bloom_free(bloom_t **);
+void bloom_add(bloom_t *, const void *, size_t);
+int bloom_test(const bloom_t *, const void *, size_t);
+void bloom_remove(bloom_t *, const void *, size_t);
+void bloom_merge(bloom_t *, const bloom_t *);
+void *bloom_save(const bloom_t *, size_t *);
+bloom_t *bloom_load(const void *, size_t);
+
+
+#endif    /* BLOOM_H */
+
+/* end of bloom.h */
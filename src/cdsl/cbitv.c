@@ -0,0 +1,993 @@
+/*
+ *  compressed bit-vector (cdsl)
+ */
+
+#include <stddef.h>    /* size_t, NULL */
+#include <string.h>    /* memcpy, memmove, memcmp */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_ALLOC, MEM_CALLOC, MEM_NEW, MEM_RESIZE, MEM_FREE */
+#include "bitv.h"
+#include "cbitv.h"
+
+
+#define BPW (8 * sizeof(unsigned long))    /* number of bits per word */
+
+#define CBITS  65536UL          /* number of bits per container */
+#define CWORD  (CBITS / BPW)    /* number of words for bitmap container */
+#define MAXARR 4096             /* max number of positions in array container */
+
+#define key(n) ((n) / CBITS)    /* key of container for bit position */
+#define low(n) ((n) % CBITS)    /* bit position in container */
+
+/* accesses bit in bitmap container */
+#define WTEST(w, x) (((w)[(x)/BPW] >> ((x)%BPW)) & 1)
+#define WSET(w, x)  ((w)[(x)/BPW] |= 1UL << ((x)%BPW))
+#define WCLR(w, x)  ((w)[(x)/BPW] &= ~(1UL << ((x)%BPW)))
+
+
+/* container types */
+enum {
+    ARRAY,     /* sorted array of bit positions */
+    BITMAP,    /* uncompressed bitmap */
+    RUN        /* sorted array of runs */
+};
+
+/* set operations */
+enum {
+    OP_OR,        /* union */
+    OP_AND,       /* intersection */
+    OP_ANDNOT,    /* difference */
+    OP_XOR        /* symmetric difference */
+};
+
+
+/* numbers of bits set in nibbles */
+static char count[] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+/* positions of lowest bits set in nibbles */
+static char first[] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+
+
+/*
+ *  compressed bit-vector
+ *
+ *  struct cbitv_t divides the range of bit positions into chunks of CBITS bits and keeps a
+ *  container only for chunks that have at least one bit set, as done by Roaring bitmaps. The
+ *  containers are sorted by their keys, the high-order parts of bit positions, and each of them
+ *  represents bits set in its chunk in one of three forms:
+ *
+ *  - ARRAY: a sorted array of positions in 16 bits, used when no more than MAXARR bits are set;
+ *  - BITMAP: an uncompressed bitmap of CWORD words, used when more than MAXARR bits are set;
+ *  - RUN: a sorted array of runs, each of which is a pair of the start position and the length
+ *    minus 1, used when a chunk consists of long runs (see cbitv_set() and cbitv_optimize()).
+ *
+ *  An empty container is never kept, and card always has the number of bits set in a container
+ *  to make counting fast. Unlike bitv_t, bits in a bitmap container are numbered in words rather
+ *  than in bytes because they are never exposed directly.
+ */
+struct cbitv_t {
+    size_t length;                    /* length in bits */
+    size_t n;                         /* number of containers */
+    size_t cap;                       /* capacity of cont */
+    struct cont {
+        size_t key;                   /* high-order part of bit positions */
+        int type;                     /* type of container */
+        size_t card;                  /* number of bits set */
+        size_t n;                     /* number of positions or runs */
+        size_t cap;                   /* capacity of array or run */
+        union {
+            unsigned short *array;    /* positions for ARRAY */
+            unsigned long *bitmap;    /* words for BITMAP */
+            unsigned short *run;      /* pairs of start and length-1 for RUN */
+        } u;
+    } *cont;                          /* containers */
+};
+
+
+/*
+ *  counts the number of bits set in a word
+ */
+static size_t popcount(unsigned long w)
+{
+    size_t c = 0;
+
+    for (; w; w >>= 8)
+        c += count[w & 0x0F] + count[(w >> 4) & 0x0F];
+
+    return c;
+}
+
+
+/*
+ *  returns the position of the lowest bit set in a non-zero word
+ */
+static size_t lowbit(unsigned long w)
+{
+    size_t b = 0;
+
+    for (; (w & 0xFF) == 0; w >>= 8)
+        b += 8;
+
+    return (w & 0x0F)? b + first[w & 0x0F]: b + 4 + first[(w >> 4) & 0x0F];
+}
+
+
+/*
+ *  counts bits set in a bitmap container
+ */
+static size_t wcount(const unsigned long *w)
+{
+    size_t i, c = 0;
+
+    for (i = 0; i < CWORD; i++)
+        c += popcount(w[i]);
+
+    return c;
+}
+
+
+/*
+ *  sets, clears or flips a range of bits in a bitmap container
+ */
+static void wrange(unsigned long *w, size_t l, size_t h, int op)
+{
+    size_t i;
+
+    for (i = l/BPW; i <= h/BPW; i++) {
+        unsigned long m = ~0UL;
+        if (i == l/BPW)
+            m &= ~0UL << (l%BPW);
+        if (i == h/BPW)
+            m &= ~0UL >> (BPW-1 - h%BPW);
+        switch(op) {
+            case OP_OR:
+                w[i] |= m;
+                break;
+            case OP_ANDNOT:
+                w[i] &= ~m;
+                break;
+            case OP_XOR:
+                w[i] ^= m;
+                break;
+        }
+    }
+}
+
+
+/*
+ *  finds the first position not less than x in an array container
+ */
+static size_t asearch(const unsigned short *a, size_t n, size_t x)
+{
+    size_t lo = 0;
+
+    while (lo < n) {
+        size_t mid = lo + (n-lo)/2;
+        if (a[mid] < x)
+            lo = mid + 1;
+        else
+            n = mid;
+    }
+
+    return lo;
+}
+
+
+/*
+ *  counts runs whose start positions are not greater than x in a run container
+ */
+static size_t rsearch(const unsigned short *r, size_t n, size_t x)
+{
+    size_t lo = 0;
+
+    while (lo < n) {
+        size_t mid = lo + (n-lo)/2;
+        if (r[2*mid] <= x)
+            lo = mid + 1;
+        else
+            n = mid;
+    }
+
+    return lo;
+}
+
+
+/*
+ *  releases storage for the data of a container
+ */
+static void cfree(struct cont *c)
+{
+    if (c->type == BITMAP)
+        MEM_FREE(c->u.bitmap);
+    else
+        MEM_FREE(c->u.array);
+}
+
+
+/*
+ *  inspects a bit in a container
+ */
+static int ctest(const struct cont *c, size_t x)
+{
+    size_t i;
+
+    switch(c->type) {
+        case ARRAY:
+            i = asearch(c->u.array, c->n, x);
+            return (i < c->n && c->u.array[i] == x);
+        case BITMAP:
+            return WTEST(c->u.bitmap, x);
+        default:    /* RUN */
+            i = rsearch(c->u.run, c->n, x);
+            return (i > 0 && x - c->u.run[2*(i-1)] <= c->u.run[2*(i-1)+1]);
+    }
+}
+
+
+/*
+ *  finds the first bit set at or after a position in a container
+ */
+static size_t cnext(const struct cont *c, size_t x)
+{
+    size_t i;
+    unsigned long w;
+
+    if (x >= CBITS)
+        return CBITS;
+
+    switch(c->type) {
+        case ARRAY:
+            i = asearch(c->u.array, c->n, x);
+            return (i < c->n)? c->u.array[i]: CBITS;
+        case BITMAP:
+            i = x / BPW;
+            for (w = c->u.bitmap[i] & (~0UL << (x%BPW)); w == 0; w = c->u.bitmap[i])
+                if (++i == CWORD)
+                    return CBITS;
+            return i*BPW + lowbit(w);
+        default:    /* RUN */
+            i = rsearch(c->u.run, c->n, x);
+            if (i > 0 && x - c->u.run[2*(i-1)] <= c->u.run[2*(i-1)+1])
+                return x;
+            return (i < c->n)? c->u.run[2*i]: CBITS;
+    }
+}
+
+
+/*
+ *  converts a container to a bitmap container
+ */
+static void tobitmap(struct cont *c)
+{
+    size_t i;
+    unsigned long *w;
+
+    if (c->type == BITMAP)
+        return;
+
+    w = MEM_CALLOC(CWORD, sizeof(*w));
+    if (c->type == ARRAY)
+        for (i = 0; i < c->n; i++)
+            WSET(w, c->u.array[i]);
+    else
+        for (i = 0; i < c->n; i++)
+            wrange(w, c->u.run[2*i], c->u.run[2*i] + c->u.run[2*i+1], OP_OR);
+    cfree(c);
+    c->type = BITMAP;
+    c->u.bitmap = w;
+    c->n = c->cap = 0;
+}
+
+
+/*
+ *  converts a bitmap container to an array container
+ */
+static void toarray(struct cont *c)
+{
+    size_t i, x;
+    unsigned short *a;
+
+    assert(c->type == BITMAP);
+    assert(c->card > 0 && c->card <= MAXARR);
+
+    a = MEM_ALLOC(c->card * sizeof(*a));
+    for (i = 0, x = cnext(c, 0); x < CBITS; x = cnext(c, x+1))
+        a[i++] = x;
+    MEM_FREE(c->u.bitmap);
+    c->type = ARRAY;
+    c->u.array = a;
+    c->n = c->cap = c->card;
+}
+
+
+/*
+ *  appends a position to a container being built in ascending order
+ */
+static void cadd(struct cont *c, size_t x)
+{
+    if (c->type == ARRAY && c->n == MAXARR)
+        tobitmap(c);
+    if (c->type == BITMAP)
+        WSET(c->u.bitmap, x);
+    else {
+        if (c->n == c->cap) {
+            c->cap = (c->cap > 0)? 2*c->cap: 4;
+            if (c->u.array)
+                MEM_RESIZE(c->u.array, c->cap * sizeof(*c->u.array));
+            else
+                c->u.array = MEM_ALLOC(c->cap * sizeof(*c->u.array));
+        }
+        c->u.array[c->n++] = x;
+    }
+    c->card++;
+}
+
+
+/*
+ *  makes a container contain only one run
+ */
+static void setrun(struct cont *c, size_t l, size_t h)
+{
+    cfree(c);
+    c->type = RUN;
+    c->u.run = MEM_ALLOC(2 * sizeof(*c->u.run));
+    c->u.run[0] = l;
+    c->u.run[1] = h - l;
+    c->n = c->cap = 1;
+    c->card = h - l + 1;
+}
+
+
+/*
+ *  duplicates a container
+ */
+static void ccopy(struct cont *d, const struct cont *s)
+{
+    size_t n;
+
+    *d = *s;
+    if (s->type == BITMAP) {
+        d->u.bitmap = MEM_ALLOC(CWORD * sizeof(*d->u.bitmap));
+        memcpy(d->u.bitmap, s->u.bitmap, CWORD * sizeof(*d->u.bitmap));
+    } else {
+        n = (s->type == RUN)? 2*s->n: s->n;
+        d->u.array = MEM_ALLOC(n * sizeof(*d->u.array));
+        memcpy(d->u.array, s->u.array, n * sizeof(*d->u.array));
+        d->cap = s->n;
+    }
+}
+
+
+/*
+ *  finds the index of the first container whose key is not less than a given key
+ */
+static size_t find(const cbitv_t *cb, size_t k)
+{
+    size_t lo = 0, n = cb->n;
+
+    while (lo < n) {
+        size_t mid = lo + (n-lo)/2;
+        if (cb->cont[mid].key < k)
+            lo = mid + 1;
+        else
+            n = mid;
+    }
+
+    return lo;
+}
+
+
+/*
+ *  inserts an empty array container into a compressed bit-vector
+ */
+static struct cont *cinsert(cbitv_t *cb, size_t i, size_t k)
+{
+    struct cont *c;
+
+    if (cb->n == cb->cap) {
+        cb->cap = (cb->cap > 0)? 2*cb->cap: 4;
+        if (cb->cont)
+            MEM_RESIZE(cb->cont, cb->cap * sizeof(*cb->cont));
+        else
+            cb->cont = MEM_ALLOC(cb->cap * sizeof(*cb->cont));
+    }
+    memmove(cb->cont+i+1, cb->cont+i, (cb->n-i) * sizeof(*cb->cont));
+    cb->n++;
+
+    c = &cb->cont[i];
+    c->key = k;
+    c->type = ARRAY;
+    c->card = c->n = c->cap = 0;
+    c->u.array = NULL;
+
+    return c;
+}
+
+
+/*
+ *  removes a container from a compressed bit-vector
+ */
+static void cremove(cbitv_t *cb, size_t i)
+{
+    cfree(&cb->cont[i]);
+    memmove(cb->cont+i, cb->cont+i+1, (cb->n-i-1) * sizeof(*cb->cont));
+    cb->n--;
+}
+
+
+/*
+ *  removes an empty container or converts a sparse bitmap container to an array one
+ */
+static void normalize(cbitv_t *cb, size_t i)
+{
+    struct cont *c = &cb->cont[i];
+
+    if (c->card == 0)
+        cremove(cb, i);
+    else if (c->type == BITMAP && c->card <= MAXARR)
+        toarray(c);
+}
+
+
+/*
+ *  sets or clears a range of bits
+ */
+static void range(cbitv_t *cb, size_t l, size_t h, int op)
+{
+    size_t k, lo, hi, i;
+    struct cont *c;
+
+    assert(cb);
+    assert(l <= h);
+    assert(h < cb->length);
+
+    for (k = key(l); k <= key(h); k++) {
+        lo = (k == key(l))? low(l): 0;
+        hi = (k == key(h))? low(h): CBITS-1;
+        i = find(cb, k);
+        if (i == cb->n || cb->cont[i].key != k) {    /* no container */
+            if (op == OP_OR)
+                setrun(cinsert(cb, i, k), lo, hi);
+            continue;
+        }
+        c = &cb->cont[i];
+        if (lo == 0 && hi == CBITS-1) {    /* whole chunk */
+            if (op == OP_OR)
+                setrun(c, lo, hi);
+            else
+                cremove(cb, i);
+            continue;
+        }
+        tobitmap(c);
+        wrange(c->u.bitmap, lo, hi, op);
+        c->card = wcount(c->u.bitmap);
+        normalize(cb, i);
+    }
+}
+
+
+/*
+ *  applies a set operation to positions in an array container
+ *
+ *  If t is an array container, its positions are merged with those of s. Otherwise, only OP_AND
+ *  and OP_ANDNOT are allowed and positions in s are filtered by testing them in t.
+ */
+static void aop(struct cont *d, const struct cont *s, const struct cont *t, int op)
+{
+    size_t i = 0, j = 0;
+    unsigned short *a;
+
+    assert(s->type == ARRAY);
+
+    d->key = s->key;
+    d->type = ARRAY;
+    d->card = d->n = 0;
+    d->cap = s->n + ((t->type == ARRAY)? t->n: 0);
+    d->u.array = a = MEM_ALLOC(d->cap * sizeof(*a));
+
+    if (t->type != ARRAY) {
+        assert(op == OP_AND || op == OP_ANDNOT);
+        for (; i < s->n; i++)
+            if (ctest(t, s->u.array[i]) == (op == OP_AND))
+                a[d->n++] = s->u.array[i];
+    } else
+        while (i < s->n || j < t->n) {
+            if (j == t->n || (i < s->n && s->u.array[i] < t->u.array[j])) {
+                if (op != OP_AND)
+                    a[d->n++] = s->u.array[i];
+                i++;
+            } else if (i == s->n || t->u.array[j] < s->u.array[i]) {
+                if (op == OP_OR || op == OP_XOR)
+                    a[d->n++] = t->u.array[j];
+                j++;
+            } else {
+                if (op == OP_OR || op == OP_AND)
+                    a[d->n++] = s->u.array[i];
+                i++, j++;
+            }
+        }
+
+    d->card = d->n;
+    if (d->card > MAXARR) {    /* possible for OP_OR and OP_XOR */
+        unsigned long *w = MEM_CALLOC(CWORD, sizeof(*w));
+        for (i = 0; i < d->n; i++)
+            WSET(w, a[i]);
+        MEM_FREE(d->u.array);
+        d->type = BITMAP;
+        d->u.bitmap = w;
+        d->n = d->cap = 0;
+    }
+}
+
+
+/*
+ *  applies a set operation to two containers with the same key
+ *
+ *  The result goes into d, which may be empty; in such a case the caller has to free it. Array
+ *  containers are merged or filtered without conversion. In other cases, the result is computed
+ *  as a bitmap and converted to an array container if it gets sparse enough.
+ */
+static void cop(struct cont *d, const struct cont *s, const struct cont *t, int op)
+{
+    size_t i;
+
+    if (s->type == ARRAY && (t->type == ARRAY || op == OP_AND || op == OP_ANDNOT))
+        aop(d, s, t, op);
+    else if (t->type == ARRAY && op == OP_AND)
+        aop(d, t, s, op);
+    else {
+        ccopy(d, s);
+        tobitmap(d);
+        if (t->type == ARRAY)
+            for (i = 0; i < t->n; i++) {
+                size_t x = t->u.array[i];
+                if (op == OP_OR)
+                    WSET(d->u.bitmap, x);
+                else if (op == OP_ANDNOT || (op == OP_XOR && WTEST(d->u.bitmap, x)))
+                    WCLR(d->u.bitmap, x);
+                else
+                    WSET(d->u.bitmap, x);
+            }
+        else if (t->type == RUN && op != OP_AND)
+            for (i = 0; i < t->n; i++)
+                wrange(d->u.bitmap, t->u.run[2*i], t->u.run[2*i] + t->u.run[2*i+1], op);
+        else {
+            struct cont tmp;
+            const unsigned long *w;
+            if (t->type == RUN) {
+                ccopy(&tmp, t);
+                tobitmap(&tmp);
+                w = tmp.u.bitmap;
+            } else
+                w = t->u.bitmap;
+            for (i = 0; i < CWORD; i++)
+                switch(op) {
+                    case OP_OR:
+                        d->u.bitmap[i] |= w[i];
+                        break;
+                    case OP_AND:
+                        d->u.bitmap[i] &= w[i];
+                        break;
+                    case OP_ANDNOT:
+                        d->u.bitmap[i] &= ~w[i];
+                        break;
+                    case OP_XOR:
+                        d->u.bitmap[i] ^= w[i];
+                        break;
+                }
+            if (t->type == RUN)
+                cfree(&tmp);
+        }
+        d->card = wcount(d->u.bitmap);
+        if (d->card > 0 && d->card <= MAXARR)
+            toarray(d);
+    }
+}
+
+
+/*
+ *  appends a container to a compressed bit-vector being built
+ *
+ *  append() takes over the data of a container; an empty container is freed instead.
+ */
+static void append(cbitv_t *cb, struct cont *c)
+{
+    if (c->card == 0)
+        cfree(c);
+    else
+        *cinsert(cb, cb->n, c->key) = *c;
+}
+
+
+/*
+ *  performs a set operation on two compressed bit-vectors
+ *
+ *  A null pointer is considered an empty compressed bit-vector. The containers of two operands
+ *  are merged by their keys; a container present in only one operand is copied or dropped
+ *  depending on the operation.
+ */
+static cbitv_t *setop(const cbitv_t *s, const cbitv_t *t, int op)
+{
+    size_t i = 0, j = 0, ns, nt;
+    cbitv_t *cb;
+    struct cont c;
+
+    assert(s || t);
+    assert(!s || !t || s->length == t->length);
+
+    cb = cbitv_new((s)? s->length: t->length);
+    ns = (s)? s->n: 0;
+    nt = (t)? t->n: 0;
+    while (i < ns || j < nt) {
+        if (j == nt || (i < ns && s->cont[i].key < t->cont[j].key)) {
+            if (op != OP_AND) {
+                ccopy(&c, &s->cont[i]);
+                append(cb, &c);
+            }
+            i++;
+        } else if (i == ns || t->cont[j].key < s->cont[i].key) {
+            if (op == OP_OR || op == OP_XOR) {
+                ccopy(&c, &t->cont[j]);
+                append(cb, &c);
+            }
+            j++;
+        } else {
+            cop(&c, &s->cont[i++], &t->cont[j++], op);
+            append(cb, &c);
+        }
+    }
+
+    return cb;
+}
+
+
+/*
+ *  creates a new compressed bit-vector
+ */
+cbitv_t *(cbitv_new)(size_t len)
+{
+    cbitv_t *cb;
+
+    MEM_NEW(cb);
+    cb->length = len;
+    cb->n = cb->cap = 0;
+    cb->cont = NULL;
+
+    return cb;
+}
+
+
+/*
+ *  destroys a compressed bit-vector
+ */
+void (cbitv_free)(cbitv_t **pcb)
+{
+    size_t i;
+
+    assert(pcb);
+    assert(*pcb);
+
+    for (i = 0; i < (*pcb)->n; i++)
+        cfree(&(*pcb)->cont[i]);
+    MEM_FREE((*pcb)->cont);
+    MEM_FREE(*pcb);
+}
+
+
+/*
+ *  returns the length of a compressed bit-vector
+ */
+size_t (cbitv_length)(const cbitv_t *cb)
+{
+    assert(cb);
+
+    return cb->length;
+}
+
+
+/*
+ *  returns the number of bits set
+ */
+size_t (cbitv_count)(const cbitv_t *cb)
+{
+    size_t i, c = 0;
+
+    assert(cb);
+
+    for (i = 0; i < cb->n; i++)
+        c += cb->cont[i].card;
+
+    return c;
+}
+
+
+/*
+ *  gets a bit in a compressed bit-vector
+ */
+int (cbitv_get)(const cbitv_t *cb, size_t n)
+{
+    size_t i;
+
+    assert(cb);
+    assert(n < cb->length);
+
+    i = find(cb, key(n));
+
+    return (i < cb->n && cb->cont[i].key == key(n) && ctest(&cb->cont[i], low(n)));
+}
+
+
+/*
+ *  changes the value of a bit in a compressed bit-vector
+ */
+int (cbitv_put)(cbitv_t *cb, size_t n, int bit)
+{
+    size_t i, j, x;
+    struct cont *c;
+    int prev;
+
+    assert(cb);
+    assert((bit & 1) == bit);
+    assert(n < cb->length);
+
+    i = find(cb, key(n));
+    x = low(n);
+    c = (i < cb->n && cb->cont[i].key == key(n))? &cb->cont[i]: NULL;
+    prev = (c && ctest(c, x));
+    if (prev == bit)
+        return prev;
+
+    if (!c)
+        c = cinsert(cb, i, key(n));
+    if (c->type == RUN || (c->type == ARRAY && bit && c->n == MAXARR))
+        tobitmap(c);
+    if (c->type == BITMAP) {
+        if (bit)
+            WSET(c->u.bitmap, x);
+        else
+            WCLR(c->u.bitmap, x);
+    } else {
+        j = asearch(c->u.array, c->n, x);
+        if (bit) {
+            cadd(c, x);    /* makes room */
+            c->card--;
+            memmove(c->u.array+j+1, c->u.array+j, (c->n-1-j) * sizeof(*c->u.array));
+            c->u.array[j] = x;
+        } else {
+            memmove(c->u.array+j, c->u.array+j+1, (c->n-1-j) * sizeof(*c->u.array));
+            c->n--;
+        }
+    }
+    c->card += (bit)? 1: -1;
+    normalize(cb, i);
+
+    return prev;
+}
+
+
+/*
+ *  sets bits to 1 in a compressed bit-vector
+ */
+void (cbitv_set)(cbitv_t *cb, size_t l, size_t h)
+{
+    range(cb, l, h, OP_OR);
+}
+
+
+/*
+ *  clears bits in a compressed bit-vector
+ */
+void (cbitv_clear)(cbitv_t *cb, size_t l, size_t h)
+{
+    range(cb, l, h, OP_ANDNOT);
+}
+
+
+/*
+ *  finds the first bit set at or after a given position
+ */
+size_t (cbitv_next)(const cbitv_t *cb, size_t n)
+{
+    size_t i, x;
+
+    assert(cb);
+    assert(n <= cb->length);
+
+    if (n == cb->length)
+        return cb->length;
+
+    for (i = find(cb, key(n)); i < cb->n; i++) {
+        x = cnext(&cb->cont[i], (cb->cont[i].key == key(n))? low(n): 0);
+        if (x < CBITS)
+            return cb->cont[i].key*CBITS + x;
+    }
+
+    return cb->length;
+}
+
+
+/*
+ *  compares two compressed bit-vectors for equality
+ */
+int (cbitv_eq)(const cbitv_t *s, const cbitv_t *t)
+{
+    size_t i;
+
+    assert(s);
+    assert(t);
+    assert(s->length == t->length);
+
+    if (s->n != t->n)
+        return 0;
+
+    for (i = 0; i < s->n; i++) {
+        const struct cont *a = &s->cont[i], *b = &t->cont[i];
+        if (a->key != b->key || a->card != b->card)
+            return 0;
+        if (a->type == b->type && a->type != RUN) {
+            if ((a->type == ARRAY)? memcmp(a->u.array, b->u.array, a->n * sizeof(*a->u.array)):
+                                    memcmp(a->u.bitmap, b->u.bitmap, CWORD * sizeof(*a->u.bitmap)))
+                return 0;
+        } else {
+            struct cont x, y;
+            int ne;
+            ccopy(&x, a);
+            ccopy(&y, b);
+            tobitmap(&x);
+            tobitmap(&y);
+            ne = memcmp(x.u.bitmap, y.u.bitmap, CWORD * sizeof(*x.u.bitmap));
+            cfree(&x);
+            cfree(&y);
+            if (ne)
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/*
+ *  returns a union of two compressed bit-vectors
+ */
+cbitv_t *(cbitv_union)(const cbitv_t *s, const cbitv_t *t)
+{
+    return setop(s, t, OP_OR);
+}
+
+
+/*
+ *  returns an intersection of two compressed bit-vectors
+ */
+cbitv_t *(cbitv_inter)(const cbitv_t *s, const cbitv_t *t)
+{
+    return setop(s, t, OP_AND);
+}
+
+
+/*
+ *  returns a difference of two compressed bit-vectors
+ */
+cbitv_t *(cbitv_minus)(const cbitv_t *s, const cbitv_t *t)
+{
+    return setop(s, t, OP_ANDNOT);
+}
+
+
+/*
+ *  returns a symmetric difference of two compressed bit-vectors
+ */
+cbitv_t *(cbitv_diff)(const cbitv_t *s, const cbitv_t *t)
+{
+    return setop(s, t, OP_XOR);
+}
+
+
+/*
+ *  finds runs in a container
+ *
+ *  runs() returns the number of runs and stores them into r if it is not a null pointer.
+ */
+static size_t runs(const struct cont *c, unsigned short *r)
+{
+    size_t x, y, n = 0;
+
+    for (x = cnext(c, 0); x < CBITS; x = cnext(c, y)) {
+        for (y = x + 1; y < CBITS && ctest(c, y); y++)
+            continue;
+        if (r) {
+            r[2*n] = x;
+            r[2*n+1] = y - x - 1;
+        }
+        n++;
+    }
+
+    return n;
+}
+
+
+/*
+ *  converts containers to run containers where they get smaller
+ *
+ *  An array container takes 2 bytes per bit set, a bitmap container takes CBITS/8 bytes and a run
+ *  container takes 4 bytes per run; the smallest form is chosen for each container.
+ */
+void (cbitv_optimize)(cbitv_t *cb)
+{
+    size_t i, nr;
+    struct cont *c;
+    unsigned short *r;
+
+    assert(cb);
+
+    for (i = 0; i < cb->n; i++) {
+        c = &cb->cont[i];
+        nr = runs(c, NULL);
+        if (4*nr < ((c->card <= MAXARR)? 2*c->card: CBITS/8)) {
+            if (c->type != RUN) {
+                r = MEM_ALLOC(2*nr * sizeof(*r));
+                runs(c, r);
+                cfree(c);
+                c->type = RUN;
+                c->u.run = r;
+                c->n = c->cap = nr;
+            }
+        } else if (c->type == RUN) {
+            tobitmap(c);
+            if (c->card <= MAXARR)
+                toarray(c);
+        }
+    }
+}
+
+
+/*
+ *  converts a bit-vector to a compressed bit-vector
+ */
+cbitv_t *(cbitv_frombitv)(const bitv_t *set)
+{
+    size_t n, len;
+    cbitv_t *cb;
+    struct cont *c = NULL;
+
+    assert(set);
+
+    len = bitv_length(set);
+    cb = cbitv_new(len);
+    for (n = bitv_next(set, 0); n < len; n = bitv_next(set, n+1)) {
+        if (!c || c->key != key(n))
+            c = cinsert(cb, cb->n, key(n));
+        cadd(c, low(n));
+    }
+
+    return cb;
+}
+
+
+/*
+ *  converts a compressed bit-vector to a bit-vector
+ */
+bitv_t *(cbitv_tobitv)(const cbitv_t *cb)
+{
+    size_t i, j, x, base;
+    bitv_t *set;
+
+    assert(cb);
+
+    set = bitv_new(cb->length);
+    for (i = 0; i < cb->n; i++) {
+        const struct cont *c = &cb->cont[i];
+        base = c->key * CBITS;
+        if (c->type == RUN)
+            for (j = 0; j < c->n; j++)
+                bitv_set(set, base + c->u.run[2*j], base + c->u.run[2*j] + c->u.run[2*j+1]);
+        else
+            for (x = cnext(c, 0); x < CBITS; x = cnext(c, x+1))
+                bitv_put(set, base + x, 1);
+    }
+
+    return set;
+}
+
+/* end of cbitv.c */
@@ -0,0 +1,43 @@
+/*
+ *  compressed bit-vector (cdsl)
+ */
+
+#ifndef CBITV_H
+#define CBITV_H
+
+#include <stddef.h>    /* size_t */
+
+#include "cdsl/bitv.h"    /* bitv_t */
+
+
+/* compressed bit-vector */
+typedef struct cbitv_t cbitv_t;
+
+
+cbitv_t *cbitv_new(size_t);
+void cbitv_free(cbitv_t **);
+size_t cbitv_length(const cbitv_t *);
+size_t cbitv_count(const cbitv_t *);
+int cbitv_get(const cbitv_t *, size_t);
+int cbitv_put(cbitv_t *, size_t, int);
+void cbitv_set(cbitv_t *, size_t, size_t);
+void cbitv_clear(cbitv_t *, size_t, size_t);
+size_t cbitv_next(const cbitv_t *, size_t);
+int cbitv_eq(const cbitv_t *, const cbitv_t *);
+cbitv_t *cbitv_union(const cbitv_t *, const cbitv_t *);
+cbitv_t *cbitv_inter(const cbitv_t *, const cbitv_t *);
+cbitv_t *cbitv_minus(const cbitv_t *, const cbitv_t *);
+cbitv_t *cbitv_diff(const cbitv_t *, const cbitv_t *);
+void cbitv_optimize(cbitv_t *);
+cbitv_t *cbitv_frombitv(const bitv_t *);
+bitv_t *cbitv_tobitv(const cbitv_t *);
+
+
+/* iterates for each bit set in compressed bit-vector */
+#define CBITV_FOREACH_SET(pos, set) for ((pos) = cbitv_next((set), 0); (pos) < cbitv_length(set);    \
+                                         (pos) = cbitv_next((set), (pos)+1))
+
+
+#endif    /* CBITV_H */
+
+/* end of cbitv.h */
@@ -0,0 +1,241 @@
+/*
+ *  deque (cdsl)
+ */
+
+#include <stddef.h>    /* NULL, size_t */
+#include <string.h>    /* memcpy */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_FREE, MEM_ALLOC, MEM_RESIZE */
+#include "deque.h"
+
+
+#define MINCAP 16    /* min capacity of deque allocated; must be power of 2 */
+
+#define SLOT(d, i) ((d)->data[((d)->head + (i)) & ((d)->cap - 1)])    /* i-th data in deque */
+
+
+/*
+ *  deque implemented by ring buffer
+ *
+ *  The i-th data of a deque is at data[(head+i) % cap]; cap is 0 or a power of 2 so that the
+ *  modulo is done by masking. The buffer grows by doubling its capacity, thus adding data to
+ *  either end takes a constant time amortized.
+ */
+struct deque_t {
+    void **data;    /* ring buffer; null if cap is 0 */
+    size_t head;    /* index of first data in buffer */
+    size_t n;       /* number of data in deque */
+    size_t cap;     /* capacity of buffer */
+};
+
+
+/*
+ *  makes the capacity of a deque at least a given value
+ *
+ *  Data wrapped around the end of the old buffer are moved to just after it, which keeps them
+ *  contiguous modulo the new capacity.
+ */
+static void grow(deque_t *d, size_t n)
+{
+    size_t cap, wrap;
+
+    if (n <= d->cap)
+        return;
+
+    for (cap = (d->cap)? d->cap: MINCAP; cap < n; cap *= 2)
+        assert(cap <= (size_t)-1 / 2 / sizeof(*d->data));
+    if (d->data)
+        MEM_RESIZE(d->data, cap*sizeof(*d->data));
+    else
+        d->data = MEM_ALLOC(cap*sizeof(*d->data));
+    if (d->head + d->n > d->cap) {
+        wrap = d->head + d->n - d->cap;
+        memcpy(d->data + d->cap, d->data, wrap*sizeof(*d->data));
+    }
+    d->cap = cap;
+}
+
+
+/*
+ *  creates a deque
+ */
+deque_t *(deque_new)(void)
+{
+    deque_t *d;
+
+    MEM_NEW(d);
+    d->data = NULL;
+    d->head = d->n = d->cap = 0;
+
+    return d;
+}
+
+
+/*
+ *  destroys a deque
+ */
+void (deque_free)(deque_t **pd)
+{
+    assert(pd);
+    assert(*pd);
+
+    MEM_FREE((*pd)->data);
+    MEM_FREE(*pd);
+}
+
+
+/*
+ *  returns the length of a deque
+ */
+size_t (deque_length)(const deque_t *d)
+{
+    assert(d);
+    return d->n;
+}
+
+
+/*
+ *  retrieves the i-th data in a deque
+ */
+void *(deque_get)(const deque_t *d, size_t i)
+{
+    assert(d);
+    assert(i < d->n);
+
+    return SLOT(d, i);
+}
+
+
+/*
+ *  replaces the i-th data in a deque
+ */
+void *(deque_put)(deque_t *d, size_t i, void *data)
+{
+    void *prev;
+
+    assert(d);
+    assert(i < d->n);
+
+    prev = SLOT(d, i);
+    SLOT(d, i) = data;
+
+    return prev;
+}
+
+
+/*
+ *  adds data before the first data in a deque
+ */
+void *(deque_addhead)(deque_t *d, void *data)
+{
+    assert(d);
+    assert(d->n < (size_t)-1);
+
+    grow(d, d->n+1);
+    d->head = (d->head - 1) & (d->cap - 1);
+    d->n++;
+    SLOT(d, 0) = data;
+
+    return data;
+}
+
+
+/*
+ *  adds data after the last data in a deque
+ */
+void *(deque_addtail)(deque_t *d, void *data)
+{
+    assert(d);
+    assert(d->n < (size_t)-1);
+
+    grow(d, d->n+1);
+    SLOT(d, d->n) = data;
+    d->n++;
+
+    return data;
+}
+
+
+/*
+ *  removes the first data in a deque
+ */
+void *(deque_remhead)(deque_t *d)
+{
+    void *data;
+
+    assert(d);
+    assert(d->n > 0);
+
+    data = SLOT(d, 0);
+    d->head = (d->head + 1) & (d->cap - 1);
+    d->n--;
+
+    return data;
+}
+
+
+/*
+ *  removes the last data in a deque
+ */
+void *(deque_remtail)(deque_t *d)
+{
+    assert(d);
+    assert(d->n > 0);
+
+    d->n--;
+
+    return SLOT(d, d->n);
+}
+
+
+/*
+ *  adds many data after the last data in a deque
+ *
+ *  Data are copied by at most two memcpy()s, one for each side of the end of the buffer.
+ */
+void (deque_pushv)(deque_t *d, void *const *v, size_t n)
+{
+    size_t i, k;
+
+    assert(d);
+    assert(v || n == 0);
+    assert(n <= (size_t)-1 - d->n);
+
+    if (n == 0)
+        return;
+
+    grow(d, d->n+n);
+    i = (d->head + d->n) & (d->cap - 1);
+    k = (n < d->cap - i)? n: d->cap - i;
+    memcpy(d->data + i, v, k*sizeof(*v));
+    memcpy(d->data, v + k, (n-k)*sizeof(*v));
+    d->n += n;
+}
+
+
+/*
+ *  removes many data from the head of a deque
+ */
+size_t (deque_popv)(deque_t *d, void **v, size_t n)
+{
+    size_t k;
+
+    assert(d);
+    assert(v || n == 0);
+
+    if (n > d->n)
+        n = d->n;
+    if (n == 0)
+        return 0;
+
+    k = (n < d->cap - d->head)? n: d->cap - d->head;
+    memcpy(v, d->data + d->head, k*sizeof(*v));
+    memcpy(v + k, d->data, (n-k)*sizeof(*v));
+    d->head = (d->head + n) & (d->cap - 1);
+    d->n -= n;
+
+    return n;
+}
+
+/* end of deque.c */
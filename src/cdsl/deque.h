@@ -0,0 +1,30 @@
+/*
+ *  deque (cdsl)
+ */
+
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* deque */
+typedef struct deque_t deque_t;
+
+
+deque_t *deque_new(void);
+void deque_free(deque_t **);
+size_t deque_length(const deque_t *);
+void *deque_get(const deque_t *, size_t);
+void *deque_put(deque_t *, size_t, void *);
+void *deque_addhead(deque_t *, void *);
+void *deque_addtail(deque_t *, void *);
+void *deque_remhead(deque_t *);
+void *deque_remtail(deque_t *);
+void deque_pushv(deque_t *, void *const *, size_t);
+size_t deque_popv(deque_t *, void **, size_t);
+
+
+#endif    /* DEQUE_H */
+
+/* end of deque.h */
@@ -2,7 +2,7 @@
  *  doubly-linked list (cdsl)
  */
 
-#include <limits.h>    /* LONG_MAX */
+#include <limits.h>    /* LONG_MAX, CHAR_BIT */
 #include <stddef.h>    /* NULL */
 #include <stdarg.h>    /* va_start, va_arg, va_end, va_list */
 
@@ -13,16 +13,20 @@
 
 /*
  *  doubly-linked list (a.k.a. ring)
+ *
+ *  Nodes are exposed to users as dlist_node_t for the functions working on nodes directly. Because
+ *  they do not know the index of a node, they invalidate the last access information when changing
+ *  the structure of a list.
  */
 struct dlist_t {
-    struct node {
-        struct node *prev;    /* previous node */
-        struct node *next;    /* next node */
-        void *data;           /* data */
-    } *head;                  /* start of list */
-    long length;              /* length of list (number of nodes) */
-    long lastidx;             /* index of last accessed node */
-    struct node *lastnode;    /* last accessed node */
+    struct dlist_node_t {
+        struct dlist_node_t *prev;    /* previous node */
+        struct dlist_node_t *next;    /* next node */
+        void *data;                   /* data */
+    } *head;                          /* start of list */
+    long length;                      /* length of list (number of nodes) */
+    long lastidx;                     /* index of last accessed node */
+    struct dlist_node_t *lastnode;    /* last accessed node */
 };
 
 
@@ -66,8 +70,8 @@ dlist_t *(dlist_list)(void *data, ...)
  */
 void (dlist_free)(dlist_t **pdlist)
 {
-    struct node *p,    /* node to be freed */
-                *q;    /* next to node freed */
+    dlist_node_t *p,    /* node to be freed */
+                 *q;    /* next to node freed */
 
     assert(pdlist);
     assert(*pdlist);
@@ -99,7 +103,7 @@ long (dlist_length)(const dlist_t *dlist)
 void *(dlist_get)(dlist_t *dlist, long i)
 {
     long n;
-    struct node *q;
+    dlist_node_t *q;
 
     assert(dlist);
     assert(i >= 0 && i < dlist->length);
@@ -139,7 +143,7 @@ void *(dlist_put)(dlist_t *dlist, long i, void *data)
 {
     long n;
     void *prev;
-    struct node *q;
+    dlist_node_t *q;
 
     assert(dlist);
     assert(i >= 0 && i < dlist->length);
@@ -177,8 +181,8 @@ void *(dlist_put)(dlist_t *dlist, long i, void *data)
  */
 void *(dlist_addtail)(dlist_t *dlist, void *data)
 {
-    struct node *p,    /* new node */
-                *head;
+    dlist_node_t *p,    /* new node */
+                 *head;
 
     assert(dlist);
     assert(dlist->length < LONG_MAX);
@@ -233,8 +237,8 @@ void *(dlist_add)(dlist_t *dlist, long pos, void *data)
         return dlist_addhead(dlist, data);
     else {    /* inserting node to middle of list */
         long i;
-        struct node *p,    /* new node */
-                    *q;    /* node to be next to new node */
+        dlist_node_t *p,    /* new node */
+                     *q;    /* node to be next to new node */
 
         /* find index of node that will become next of new node;
            if pos < 0, pos+(length+1) == positive value for same position */
@@ -286,7 +290,7 @@ void *(dlist_remove)(dlist_t *dlist, long i)
 {
     long n;
     void *data;
-    struct node *q;    /* node to be removed */
+    dlist_node_t *q;    /* node to be removed */
 
     assert(dlist);
     assert(dlist->length > 0);
@@ -346,7 +350,7 @@ void *(dlist_remove)(dlist_t *dlist, long i)
 void *(dlist_remtail)(dlist_t *dlist)
 {
     void *data;
-    struct node *tail;
+    dlist_node_t *tail;
 
     assert(dlist);
     assert(dlist->length > 0);
@@ -374,9 +378,11 @@ void *(dlist_remhead)(dlist_t *dlist)
     assert(dlist);
     assert(dlist->length > 0);
 
-    /* dlist->lastnode adjusted in dlist_remtail() */
+    /* dlist->lastnode adjusted in dlist_remtail() if it refers to head; otherwise its index
+       decreases by one */
 
-    dlist->head = dlist->head->prev;    /* turns head to tail */
+    dlist->head = dlist->head->next;    /* turns head to tail */
+    dlist->lastidx--;
 
     return dlist_remtail(dlist);
 }
@@ -388,7 +394,7 @@ void *(dlist_remhead)(dlist_t *dlist)
 void (dlist_shift)(dlist_t *dlist, long n)
 {
     long i;
-    struct node *q;    /* new head node after shift */
+    dlist_node_t *q;    /* new head node after shift */
 
     assert(dlist);
     assert(n >= -dlist->length);
@@ -399,6 +405,8 @@ void (dlist_shift)(dlist_t *dlist, long n)
         i = dlist->length - n;
     else    /* shift to left; head goes to right */
         i = -n;    /* possibility of overflow in 2sC representation */
+    if (i == dlist->length)    /* shift by length is no shift; head stays */
+        i = 0;
 
     q = NULL;
 
@@ -430,4 +438,377 @@ void (dlist_shift)(dlist_t *dlist, long n)
     dlist->head = q;
 }
 
+/*
+ *  returns the head node of a list
+ */
+dlist_node_t *(dlist_first)(const dlist_t *dlist)
+{
+    assert(dlist);
+
+    return dlist->head;
+}
+
+
+/*
+ *  returns the tail node of a list
+ */
+dlist_node_t *(dlist_last)(const dlist_t *dlist)
+{
+    assert(dlist);
+
+    return (dlist->head)? dlist->head->prev: NULL;
+}
+
+
+/*
+ *  returns the next node of a node
+ */
+dlist_node_t *(dlist_next)(const dlist_t *dlist, const dlist_node_t *node)
+{
+    assert(dlist);
+    assert(node);
+
+    return (node->next == dlist->head)? NULL: node->next;
+}
+
+
+/*
+ *  returns the previous node of a node
+ */
+dlist_node_t *(dlist_prev)(const dlist_t *dlist, const dlist_node_t *node)
+{
+    assert(dlist);
+    assert(node);
+
+    return (node == dlist->head)? NULL: node->prev;
+}
+
+
+/*
+ *  returns data stored in a node
+ */
+void *(dlist_data)(const dlist_node_t *node)
+{
+    assert(node);
+
+    return node->data;
+}
+
+
+/*
+ *  replaces data stored in a node
+ */
+void *(dlist_setdata)(dlist_node_t *node, void *data)
+{
+    void *prev;
+
+    assert(node);
+
+    prev = node->data;
+    node->data = data;
+
+    return prev;
+}
+
+
+/*
+ *  inserts a new node before a node
+ */
+dlist_node_t *(dlist_insertbefore)(dlist_t *dlist, dlist_node_t *node, void *data)
+{
+    dlist_node_t *p;
+
+    assert(dlist);
+    assert(dlist->length < LONG_MAX);
+
+    if (!node || node == dlist->head) {
+        dlist_addtail(dlist, data);
+        p = dlist->head->prev;    /* new node is tail */
+        if (node)    /* new node becomes head */
+            dlist->head = p;
+        dlist->lastnode = NULL;
+        return p;
+    }
+
+    MEM_NEW(p);
+    p->prev = node->prev;
+    node->prev->next = p;
+    p->next = node;
+    node->prev = p;
+    p->data = data;
+    dlist->length++;
+    dlist->lastnode = NULL;
+
+    return p;
+}
+
+
+/*
+ *  removes a node from a list
+ */
+void *(dlist_erase)(dlist_t *dlist, dlist_node_t *node)
+{
+    void *data;
+
+    assert(dlist);
+    assert(dlist->length > 0);
+    assert(node);
+
+    if (node == dlist->head)
+        dlist->head = node->next;
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    data = node->data;
+    MEM_FREE(node);
+    if (--dlist->length == 0)
+        dlist->head = NULL;
+    dlist->lastnode = NULL;
+
+    return data;
+}
+
+
+/*
+ *  unlinks a node and links it before the head node
+ */
+static void relink(dlist_t *dlist, dlist_node_t *node)
+{
+    dlist_node_t *head = dlist->head;
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = head->prev;
+    head->prev->next = node;
+    node->next = head;
+    head->prev = node;
+}
+
+
+/*
+ *  moves a node to the head of a list
+ */
+void (dlist_movetohead)(dlist_t *dlist, dlist_node_t *node)
+{
+    assert(dlist);
+    assert(node);
+
+    if (node == dlist->head)
+        return;
+    if (node != dlist->head->prev)
+        relink(dlist, node);
+    dlist->head = node;    /* tail becomes head by moving head pointer */
+    dlist->lastnode = NULL;
+}
+
+
+/*
+ *  moves a node to the tail of a list
+ */
+void (dlist_movetotail)(dlist_t *dlist, dlist_node_t *node)
+{
+    assert(dlist);
+    assert(node);
+
+    if (node == dlist->head->prev)
+        return;
+    if (node == dlist->head)
+        dlist->head = node->next;    /* head becomes tail by moving head pointer */
+    else
+        relink(dlist, node);
+    dlist->lastnode = NULL;
+}
+
+
+/*
+ *  locates the i-th node of a list
+ *
+ *  Unlike dlist_get(), locate() does not change the last access information because it is used by
+ *  functions that adjust it for themselves.
+ */
+static dlist_node_t *locate(const dlist_t *dlist, long i)
+{
+    long n;
+    dlist_node_t *q = dlist->head;
+
+    if (dlist->lastnode && dlist->lastidx == i)
+        return dlist->lastnode;
+
+    if (i <= dlist->length / 2)
+        for (n = i; n-- > 0; q = q->next)
+            continue;
+    else
+        for (n = dlist->length-i; n-- > 0; q = q->prev)
+            continue;
+
+    return q;
+}
+
+
+/*
+ *  moves nodes in a range of a list to a specified position in another list
+ *
+ *  Once the first and the last nodes of the range and the node to be next to them are located,
+ *  the chain of nodes is relinked as a whole regardless of its length.
+ */
+void (dlist_splice)(dlist_t *dst, long pos, dlist_t *src, long from, long to)
+{
+    long n, i;
+    dlist_node_t *first, *last, *q;
+
+    assert(dst);
+    assert(src);
+    assert(dst != src);
+    assert(from >= 0 && from <= to && to <= src->length);
+    assert(pos >= -dst->length);
+    assert(pos <= dst->length+1);
+    assert(dst->length <= LONG_MAX - (to-from));
+
+    if ((n = to - from) == 0)
+        return;
+
+    /* unlinks range from src */
+    first = locate(src, from);
+    last = (n == 1)? first: locate(src, to-1);
+    if (n == src->length)
+        src->head = NULL;
+    else {
+        first->prev->next = last->next;
+        last->next->prev = first->prev;
+        if (from == 0)
+            src->head = last->next;
+    }
+    src->length -= n;
+    if (src->lastnode) {    /* adjusts last access information */
+        if (src->lastidx >= to)
+            src->lastidx -= n;
+        else if (src->lastidx >= from)
+            src->lastnode = NULL;
+    }
+
+    /* index of first node in dst; see dlist_add() for pos */
+    i = (pos <= 0)? pos+dst->length: pos-1;
+
+    /* links range to dst */
+    if (dst->length == 0) {
+        dst->head = first;
+        first->prev = last;
+        last->next = first;
+    } else {
+        q = (i == dst->length)? dst->head: locate(dst, i);    /* to be next to range */
+        first->prev = q->prev;
+        q->prev->next = first;
+        last->next = q;
+        q->prev = last;
+        if (i == 0)
+            dst->head = first;
+    }
+    dst->length += n;
+    if (dst->lastnode && dst->lastidx >= i)
+        dst->lastidx += n;
+}
+
+
+/*
+ *  appends all nodes of a list to another list
+ */
+void (dlist_concat)(dlist_t *dst, dlist_t *src)
+{
+    dlist_node_t *tail;
+
+    assert(dst);
+    assert(src);
+    assert(dst != src);
+    assert(dst->length <= LONG_MAX - src->length);
+
+    if (src->length == 0)
+        return;
+
+    if (dst->length == 0)
+        dst->head = src->head;
+    else {
+        tail = src->head->prev;
+        dst->head->prev->next = src->head;
+        src->head->prev = dst->head->prev;
+        tail->next = dst->head;
+        dst->head->prev = tail;
+    }
+    dst->length += src->length;
+
+    src->head = NULL;
+    src->length = 0;
+    src->lastnode = NULL;
+}
+
+
+/*
+ *  merges two sorted chains of nodes linked by next
+ *
+ *  As in list_sort() from the list library, a node of b goes first only when it is less than that
+ *  of a for stability.
+ */
+static dlist_node_t *merge(dlist_node_t *a, dlist_node_t *b, int cmp(const void *, const void *))
+{
+    dlist_node_t *head, **pnode = &head;
+
+    while (a && b) {
+        if (cmp(b->data, a->data) < 0) {
+            *pnode = b;
+            b = b->next;
+        } else {
+            *pnode = a;
+            a = a->next;
+        }
+        pnode = &(*pnode)->next;
+    }
+    *pnode = (a)? a: b;
+
+    return head;
+}
+
+
+/*
+ *  sorts a list
+ *
+ *  The ring is opened into a chain linked by next and sorted bottom-up without allocation as
+ *  list_sort() does; prev links and the ring are restored afterwards. Nodes are only relinked, so
+ *  node handles remain valid.
+ */
+void (dlist_sort)(dlist_t *dlist, int cmp(const void *, const void *))
+{
+    int i, n = 0;
+    dlist_node_t *p, *q, *bin[sizeof(long) * CHAR_BIT];
+
+    assert(dlist);
+    assert(cmp);
+
+    if (dlist->length < 2)
+        return;
+
+    q = dlist->head;
+    q->prev->next = NULL;    /* opens ring */
+    while (q) {
+        p = q;
+        q = q->next;
+        p->next = NULL;
+        for (i = 0; i < n && bin[i]; i++) {
+            p = merge(bin[i], p, cmp);    /* bin[i] has preceding nodes */
+            bin[i] = NULL;
+        }
+        if (i == n)
+            n++;
+        bin[i] = p;
+    }
+    for (p = NULL, i = 0; i < n; i++)
+        if (bin[i])
+            p = merge(bin[i], p, cmp);
+
+    dlist->head = p;
+    for (; p->next; p = p->next)
+        p->next->prev = p;
+    p->next = dlist->head;    /* closes ring */
+    dlist->head->prev = p;
+
+    dlist->lastnode = NULL;
+}
+
 /* end of dlist.c */
@@ -9,6 +9,9 @@
 /* doubly-linked list */
 typedef struct dlist_t dlist_t;
 
+/* node in doubly-linked list */
+typedef struct dlist_node_t dlist_node_t;
+
 
 dlist_t *dlist_new(void);
 dlist_t *dlist_list(void *, ...);
@@ -23,6 +26,19 @@ long dlist_length(const dlist_t *);
 void *dlist_get(dlist_t *, long);
 void *dlist_put(dlist_t *, long, void *);
 void dlist_shift(dlist_t *, long);
+dlist_node_t *dlist_first(const dlist_t *);
+dlist_node_t *dlist_last(const dlist_t *);
+dlist_node_t *dlist_next(const dlist_t *, const dlist_node_t *);
+dlist_node_t *dlist_prev(const dlist_t *, const dlist_node_t *);
+void *dlist_data(const dlist_node_t *);
+void *dlist_setdata(dlist_node_t *, void *);
+dlist_node_t *dlist_insertbefore(dlist_t *, dlist_node_t *, void *);
+void *dlist_erase(dlist_t *, dlist_node_t *);
+void dlist_movetohead(dlist_t *, dlist_node_t *);
+void dlist_movetotail(dlist_t *, dlist_node_t *);
+void dlist_splice(dlist_t *, long, dlist_t *, long, long);
+void dlist_concat(dlist_t *, dlist_t *);
+void dlist_sort(dlist_t *, int (const void *, const void *));
 
 
 #endif    /* DLIST_H */
@@ -0,0 +1,308 @@
+/*
+ *  heap (cdsl)
+ */
+
+#include <stddef.h>    /* NULL, size_t */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_FREE, MEM_ALLOC, MEM_RESIZE */
+#include "heap.h"
+
+
+#define MINCAP 16    /* min capacity of heap allocated */
+#define D      4     /* number of children of node */
+
+#define NONE ((size_t)-1)    /* end of free list of handles */
+
+
+/*
+ *  item in heap
+ */
+struct item {
+    void *data;    /* data */
+    size_t id;     /* handle */
+};
+
+
+/*
+ *  4-ary heap
+ *
+ *  item[0] holds the smallest data and the children of item[i] are item[D*i+1] to item[D*i+D].
+ *  With 4 children a node and its siblings tend to share a cache line and the tree is half as
+ *  tall as a binary heap, which pays for an extra comparison per level when popping.
+ *
+ *  A handle is an index into pos, which gives the index of the item with the handle in item.
+ *  Handles not in use are linked through pos from free; nid handles have ever been handed out.
+ */
+struct heap_t {
+    int (*cmp)(const void *, const void *);    /* comparison function */
+    struct item *item;                         /* items in heap order; null if cap is 0 */
+    size_t *pos;                               /* positions of items indexed by handles */
+    size_t n;                                  /* number of items */
+    size_t cap;                                /* capacity of item and pos */
+    size_t nid;                                /* number of handles handed out */
+    size_t free;                               /* first free handle */
+};
+
+
+/*
+ *  makes the capacity of a heap at least a given value
+ */
+static void grow(heap_t *h, size_t n)
+{
+    size_t cap;
+
+    if (n <= h->cap)
+        return;
+
+    assert(n <= (size_t)-1 / sizeof(*h->item));
+    cap = (h->cap > (size_t)-1 / 2 / sizeof(*h->item))? n: h->cap * 2;
+    if (cap < n)
+        cap = n;
+    if (cap < MINCAP)
+        cap = MINCAP;
+    if (h->item) {
+        MEM_RESIZE(h->item, cap*sizeof(*h->item));
+        MEM_RESIZE(h->pos, cap*sizeof(*h->pos));
+    } else {
+        h->item = MEM_ALLOC(cap*sizeof(*h->item));
+        h->pos = MEM_ALLOC(cap*sizeof(*h->pos));
+    }
+    h->cap = cap;
+}
+
+
+/*
+ *  moves an item toward the root until heap order is restored
+ */
+static void siftup(heap_t *h, size_t i)
+{
+    size_t p;
+    struct item x = h->item[i];
+
+    while (i > 0) {
+        p = (i-1) / D;
+        if (h->cmp(x.data, h->item[p].data) >= 0)
+            break;
+        h->item[i] = h->item[p];
+        h->pos[h->item[i].id] = i;
+        i = p;
+    }
+    h->item[i] = x;
+    h->pos[x.id] = i;
+}
+
+
+/*
+ *  moves an item toward the leaves until heap order is restored
+ */
+static void siftdown(heap_t *h, size_t i)
+{
+    size_t c, m, end;
+    struct item x = h->item[i];
+
+    while (i < (h->n + D-2) / D) {    /* i has a child */
+        c = D*i + 1;
+        end = (h->n - c > D)? c + D: h->n;
+        for (m = c++; c < end; c++)
+            if (h->cmp(h->item[c].data, h->item[m].data) < 0)
+                m = c;
+        if (h->cmp(h->item[m].data, x.data) >= 0)
+            break;
+        h->item[i] = h->item[m];
+        h->pos[h->item[i].id] = i;
+        i = m;
+    }
+    h->item[i] = x;
+    h->pos[x.id] = i;
+}
+
+
+/*
+ *  removes the i-th item from a heap
+ */
+static void *delete(heap_t *h, size_t i)
+{
+    struct item x = h->item[i];
+
+    h->n--;
+    if (i < h->n) {
+        h->item[i] = h->item[h->n];
+        if (h->cmp(h->item[i].data, x.data) < 0)
+            siftup(h, i);
+        else
+            siftdown(h, i);
+    }
+    h->pos[x.id] = h->free;
+    h->free = x.id;
+
+    return x.data;
+}
+
+
+/*
+ *  creates a heap
+ */
+heap_t *(heap_new)(int hint, int cmp(const void *, const void *))
+{
+    heap_t *h;
+
+    assert(hint >= 0);
+    assert(cmp);
+
+    MEM_NEW(h);
+    h->cmp = cmp;
+    h->item = NULL;
+    h->pos = NULL;
+    h->n = h->cap = h->nid = 0;
+    h->free = NONE;
+    if (hint > 0)
+        grow(h, hint);
+
+    return h;
+}
+
+
+/*
+ *  creates a heap from an array
+ *
+ *  Sifting down every internal node from the last one takes a linear time in total.
+ */
+heap_t *(heap_build)(void *const *v, size_t n, int cmp(const void *, const void *))
+{
+    size_t i;
+    heap_t *h;
+
+    assert(v || n == 0);
+
+    h = heap_new(0, cmp);
+    grow(h, n);
+    for (i = 0; i < n; i++) {
+        h->item[i].data = v[i];
+        h->item[i].id = h->pos[i] = i;
+    }
+    h->n = h->nid = n;
+    for (i = (n + D-2) / D; i > 0; i--)
+        siftdown(h, i-1);
+
+    return h;
+}
+
+
+/*
+ *  destroys a heap
+ */
+void (heap_free)(heap_t **ph)
+{
+    assert(ph);
+    assert(*ph);
+
+    MEM_FREE((*ph)->item);
+    MEM_FREE((*ph)->pos);
+    MEM_FREE(*ph);
+}
+
+
+/*
+ *  returns the length of a heap
+ */
+size_t (heap_length)(const heap_t *h)
+{
+    assert(h);
+    return h->n;
+}
+
+
+/*
+ *  adds data to a heap
+ */
+size_t (heap_push)(heap_t *h, void *data)
+{
+    size_t id;
+
+    assert(h);
+    assert(h->n < NONE);
+
+    grow(h, h->n+1);
+    if (h->free != NONE) {
+        id = h->free;
+        h->free = h->pos[id];
+    } else
+        id = h->nid++;
+    h->item[h->n].data = data;
+    h->item[h->n].id = id;
+    siftup(h, h->n++);
+
+    return id;
+}
+
+
+/*
+ *  returns the smallest data in a heap
+ */
+void *(heap_peek)(const heap_t *h)
+{
+    assert(h);
+    assert(h->n > 0);
+
+    return h->item[0].data;
+}
+
+
+/*
+ *  removes the smallest data from a heap
+ */
+void *(heap_pop)(heap_t *h)
+{
+    assert(h);
+    assert(h->n > 0);
+
+    return delete(h, 0);
+}
+
+
+/*
+ *  retrieves data with a handle
+ */
+void *(heap_get)(const heap_t *h, size_t id)
+{
+    assert(h);
+    assert(id < h->nid && h->pos[id] < h->n && h->item[h->pos[id]].id == id);
+
+    return h->item[h->pos[id]].data;
+}
+
+
+/*
+ *  replaces data with a handle by smaller or equal data
+ */
+void *(heap_decrease)(heap_t *h, size_t id, void *data)
+{
+    size_t i;
+    void *prev;
+
+    assert(h);
+    assert(id < h->nid && h->pos[id] < h->n && h->item[h->pos[id]].id == id);
+
+    i = h->pos[id];
+    prev = h->item[i].data;
+    assert(h->cmp(data, prev) <= 0);
+    h->item[i].data = data;
+    siftup(h, i);
+
+    return prev;
+}
+
+
+/*
+ *  removes data with a handle from a heap
+ */
+void *(heap_remove)(heap_t *h, size_t id)
+{
+    assert(h);
+    assert(id < h->nid && h->pos[id] < h->n && h->item[h->pos[id]].id == id);
+
+    return delete(h, h->pos[id]);
+}
+
+/* end of heap.c */
@@ -0,0 +1,29 @@
+/*
+ *  heap (cdsl)
+ */
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* heap */
+typedef struct heap_t heap_t;
+
+
+heap_t *heap_new(int, int (const void *, const void *));
+heap_t *heap_build(void *const *, size_t, int (const void *, const void *));
+void heap_free(heap_t **);
+size_t heap_length(const heap_t *);
+size_t heap_push(heap_t *, void *);
+void *heap_peek(const heap_t *);
+void *heap_pop(heap_t *);
+void *heap_get(const heap_t *, size_t);
+void *heap_decrease(heap_t *, size_t, void *);
+void *heap_remove(heap_t *, size_t);
+
+
+#endif    /* HEAP_H */
+
+/* end of heap.h */
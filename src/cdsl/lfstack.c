@@ -0,0 +1,264 @@
+/*
+ *  lock-free stack (cdsl)
+ */
+
+#include <limits.h>    /* ULONG_MAX */
+#include <stddef.h>    /* NULL */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW0, MEM_ALLOC, MEM_FREE */
+#include "lfstack.h"
+
+
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define ATOMIC(p)          ((_Atomic unsigned long *)(p))
+#define ATOMICP(p)         ((struct node *_Atomic *)(p))
+#define LOAD(p)            atomic_load_explicit(ATOMIC(p), memory_order_acquire)
+#define STORE(p, v)        atomic_store_explicit(ATOMIC(p), (v), memory_order_relaxed)
+#define CAS(p, e, d)       atomic_compare_exchange_weak_explicit(ATOMIC(p), (e), (d),          \
+                                                                 memory_order_acq_rel,         \
+                                                                 memory_order_acquire)
+#define FETCH_ADD(p, v)    atomic_fetch_add_explicit(ATOMIC(p), (v), memory_order_relaxed)
+#define LOADP(p)           atomic_load_explicit(ATOMICP(p), memory_order_acquire)
+#define CASP(p, e, d)      atomic_compare_exchange_strong_explicit(ATOMICP(p), (e), (d),       \
+                                                                   memory_order_acq_rel,       \
+                                                                   memory_order_acquire)
+#elif defined(__ATOMIC_ACQ_REL)    /* gcc built-ins */
+#define LOAD(p)            __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE(p, v)        __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define CAS(p, e, d)       __atomic_compare_exchange_n((p), (e), (d), 1, __ATOMIC_ACQ_REL,     \
+                                                       __ATOMIC_ACQUIRE)
+#define FETCH_ADD(p, v)    __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define LOADP(p)           __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CASP(p, e, d)      __atomic_compare_exchange_n((p), (e), (d), 0, __ATOMIC_ACQ_REL,     \
+                                                       __ATOMIC_ACQUIRE)
+#else    /* no atomic operations; lfstack_*() are not thread-safe */
+#define NOATOMIC
+#define LOAD(p)            (*(p))
+#define STORE(p, v)        (*(p) = (v))
+#define CAS(p, e, d)       cas((p), (e), (d))
+#define FETCH_ADD(p, v)    ((*(p) += (v)) - (v))
+#define LOADP(p)           (*(p))
+#define CASP(p, e, d)      (*(p) = (d), 1)
+#endif    /* __STDC_VERSION__ */
+
+/* tagged index; index+1 in lower IDXBITS bits and tag in the others */
+#if ULONG_MAX > 0xFFFFFFFFUL
+#define IDXBITS 32
+#else
+#define IDXBITS 20
+#endif    /* ULONG_MAX */
+#define IDXMASK ((1UL << IDXBITS) - 1)
+#define TAGGED(t, i) ((((t) >> IDXBITS) + 1) << IDXBITS | (i))    /* tag of t incremented */
+
+#define LOGBASE 6                                  /* log2 of number of nodes in first chunk */
+#define NCHUNK  (IDXBITS - LOGBASE)                /* max number of chunks */
+#define MAXNODE ((1UL << LOGBASE) * ((1UL << NCHUNK) - 1))    /* max number of nodes */
+
+
+/*
+ *  node
+ *
+ *  next is accessed atomically because a thread popping a node may read it while another thread
+ *  pushes the same node again after recycling it.
+ */
+struct node {
+    unsigned long next;    /* index+1 of next node; 0 for none */
+    void *data;            /* data */
+};
+
+
+/*
+ *  lock-free stack
+ *
+ *  Nodes are never freed until the stack is destroyed; a node popped goes to the free list, from
+ *  which pushing takes a node before getting a new one. Nodes are referred to by indices so that
+ *  the top of a stack fits in a word with a tag; the tag changes on every update, which makes a
+ *  compare-and-swap fail when the top has been popped and pushed again between its load and the
+ *  swap (the ABA problem). The tag has 32 bits with 64-bit unsigned long, but only 12 bits with
+ *  32-bit one; there the tag wraps after 4096 updates, and a thread stalled between the load and
+ *  the swap for that many updates may succeed wrongly. A double-width compare-and-swap would
+ *  avoid it, but is not portably available.
+ *
+ *  Chunks of nodes are allocated on demand; the k-th chunk has 2^(LOGBASE+k) nodes, so that an
+ *  index finds its chunk without a lock and allocated nodes never move.
+ */
+struct lfstack_t {
+    unsigned long head;              /* tagged index of top node */
+    unsigned long free;              /* tagged index of top free node */
+    unsigned long next;              /* number of nodes handed out from chunks */
+    struct node *chunk[NCHUNK];      /* chunks of nodes */
+};
+
+
+#ifdef NOATOMIC
+/*
+ *  emulates compare-and-swap without atomicity
+ */
+static int cas(unsigned long *p, unsigned long *e, unsigned long d)
+{
+    if (*p == *e) {
+        *p = d;
+        return 1;
+    }
+    *e = *p;
+
+    return 0;
+}
+#endif    /* NOATOMIC */
+
+
+/*
+ *  finds a node from its index
+ */
+static struct node *node(lfstack_t *stk, unsigned long i)
+{
+    int k;
+    unsigned long j;
+
+    for (k = 0, j = (i >> LOGBASE) + 1; j > 1; j >>= 1)
+        k++;
+
+    return LOADP(&stk->chunk[k]) + (i - ((1UL << LOGBASE) * ((1UL << k) - 1)));
+}
+
+
+/*
+ *  pushes a node to a stack whose top is *top
+ */
+static void push(lfstack_t *stk, unsigned long *top, unsigned long i)
+{
+    unsigned long t;
+    struct node *p = node(stk, i);
+
+    t = LOAD(top);
+    do {
+        STORE(&p->next, t & IDXMASK);
+    } while (!CAS(top, &t, TAGGED(t, i+1)));
+}
+
+
+/*
+ *  pops a node from a stack whose top is *top
+ *
+ *  The next of a node read here may be stale if the node has been popped by another thread, but
+ *  then the tag has changed and the swap fails.
+ */
+static unsigned long pop(lfstack_t *stk, unsigned long *top)
+{
+    unsigned long t;
+
+    t = LOAD(top);
+    do {
+        if ((t & IDXMASK) == 0)
+            return 0;
+    } while (!CAS(top, &t, TAGGED(t, LOAD(&node(stk, (t & IDXMASK) - 1)->next))));
+
+    return t & IDXMASK;
+}
+
+
+/*
+ *  gets a node from the free list or a chunk
+ *
+ *  When two threads need the same chunk, both allocate one but only one of them is installed.
+ */
+static unsigned long getnode(lfstack_t *stk)
+{
+    int k;
+    unsigned long i, j;
+    struct node *p, *q;
+
+    if ((i = pop(stk, &stk->free)) != 0)
+        return i - 1;
+
+    i = FETCH_ADD(&stk->next, 1);
+    assert(i < MAXNODE);
+    for (k = 0, j = (i >> LOGBASE) + 1; j > 1; j >>= 1)
+        k++;
+    if (!LOADP(&stk->chunk[k])) {
+        p = MEM_ALLOC((1UL << (LOGBASE+k)) * sizeof(*p));
+        q = NULL;
+        if (!CASP(&stk->chunk[k], &q, p))
+            MEM_FREE(p);
+    }
+
+    return i;
+}
+
+
+/*
+ *  creates a lock-free stack
+ */
+lfstack_t *(lfstack_new)(void)
+{
+    lfstack_t *stk;
+
+    MEM_NEW0(stk);
+
+    return stk;
+}
+
+
+/*
+ *  destroys a lock-free stack
+ */
+void (lfstack_free)(lfstack_t **stk)
+{
+    int k;
+
+    assert(stk);
+    assert(*stk);
+
+    for (k = 0; k < NCHUNK; k++)
+        MEM_FREE((*stk)->chunk[k]);
+    MEM_FREE(*stk);
+}
+
+
+/*
+ *  pushes data into a lock-free stack
+ */
+void (lfstack_push)(lfstack_t *stk, void *data)
+{
+    unsigned long i;
+
+    assert(stk);
+
+    i = getnode(stk);
+    node(stk, i)->data = data;
+    push(stk, &stk->head, i);
+}
+
+
+/*
+ *  pops data from a lock-free stack
+ */
+int (lfstack_pop)(lfstack_t *stk, void **pdata)
+{
+    unsigned long i;
+
+    assert(stk);
+    assert(pdata);
+
+    if ((i = pop(stk, &stk->head)) == 0)
+        return 0;
+    *pdata = node(stk, i-1)->data;
+    push(stk, &stk->free, i-1);
+
+    return 1;
+}
+
+
+/*
+ *  inspects if a lock-free stack is empty
+ */
+int (lfstack_empty)(const lfstack_t *stk)
+{
+    assert(stk);
+
+    return ((LOAD(&((lfstack_t *)stk)->head) & IDXMASK) == 0);
+}
+
+/* end of lfstack.c */
@@ -0,0 +1,22 @@
+/*
+ *  lock-free stack (cdsl)
+ */
+
+#ifndef LFSTACK_H
+#define LFSTACK_H
+
+
+/* lock-free stack */
+typedef struct lfstack_t lfstack_t;
+
+
+lfstack_t *lfstack_new(void);
+void lfstack_free(lfstack_t **);
+void lfstack_push(lfstack_t *, void *);
+int lfstack_pop(lfstack_t *, void **);
+int lfstack_empty(const lfstack_t *);
+
+
+#endif    /* LFSTACK_H */
+
+/* end of lfstack.h */
@@ -2,6 +2,7 @@
  *  list (cdsl)
  */
 
+#include <limits.h>    /* CHAR_BIT */
 #include <stdarg.h>    /* va_list, va_start, va_arg, va_end */
 #include <stddef.h>    /* NULL, size_t */
 
@@ -85,7 +86,8 @@ list_t *(list_list)(void *data, ...)
  *  TODO:
  *    - the time complexity of the current implementation is O(N) where N indicates the number of
  *      nodes in a list. With a circular list, where the next node of the last node set to the
- *      head, it is possible for both pushing and appending to be done in a constant time.
+ *      head, it is possible for both pushing and appending to be done in a constant time. For
+ *      now, list_builder_t serves to build a list by appending nodes in a constant time.
  */
 list_t *(list_append)(list_t *list, list_t *tail)
 {
@@ -288,4 +290,112 @@ void **(list_toarray)(const list_t *list, void *end)
     return array;
 }
 
+
+/*
+ *  merges two sorted lists
+ *
+ *  A node of b goes first only when it is less than that of a, which keeps the merge stable
+ *  provided that nodes in a precede those in b in the original list.
+ */
+static list_t *merge(list_t *a, list_t *b, int cmp(const void *, const void *))
+{
+    list_t *head, **plist = &head;
+
+    while (a && b) {
+        if (cmp(b->data, a->data) < 0) {
+            *plist = b;
+            b = b->next;
+        } else {
+            *plist = a;
+            a = a->next;
+        }
+        plist = &(*plist)->next;
+    }
+    *plist = (a)? a: b;
+
+    return head;
+}
+
+
+/*
+ *  sorts a list
+ *
+ *  Nodes are merged bottom-up; bin[i] holds a sorted list of 2^i nodes or nothing, like a binary
+ *  counter incremented by each node taken from a list. Since a list cannot have more than SIZE_MAX
+ *  nodes, bins of a fixed number suffice and no storage is allocated.
+ */
+list_t *(list_sort)(list_t *list, int cmp(const void *, const void *))
+{
+    int i, n = 0;
+    list_t *p, *bin[sizeof(size_t) * CHAR_BIT];
+
+    assert(cmp);
+
+    while (list) {
+        p = list;
+        list = list->next;
+        p->next = NULL;
+        for (i = 0; i < n && bin[i]; i++) {
+            p = merge(bin[i], p, cmp);    /* bin[i] has preceding nodes */
+            bin[i] = NULL;
+        }
+        if (i == n)
+            n++;
+        bin[i] = p;
+    }
+
+    for (p = NULL, i = 0; i < n; i++)
+        if (bin[i])
+            p = merge(bin[i], p, cmp);
+
+    return p;
+}
+
+
+/*
+ *  prepares a builder for a new list
+ */
+void (list_binit)(list_builder_t *b)
+{
+    assert(b);
+
+    b->head = b->tail = NULL;
+}
+
+
+/*
+ *  adds a new node after the last node of a list being built
+ */
+void (list_baddtail)(list_builder_t *b, void *data)
+{
+    list_t *p;
+
+    assert(b);
+
+    MEM_NEW(p);
+    p->data = data;
+    p->next = NULL;
+    if (b->tail)
+        b->tail->next = p;
+    else
+        b->head = p;
+    b->tail = p;
+}
+
+
+/*
+ *  finishes building a list
+ */
+list_t *(list_bfinish)(list_builder_t *b)
+{
+    list_t *list;
+
+    assert(b);
+
+    list = b->head;
+    b->head = b->tail = NULL;
+
+    return list;
+}
+
 /* end of list.c */
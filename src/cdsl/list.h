@@ -14,6 +14,12 @@ typedef struct list_t {
     struct list_t *next;    /* next node */
 } list_t;
 
+/* list builder */
+typedef struct list_builder_t {
+    list_t *head;    /* first node */
+    list_t *tail;    /* last node */
+} list_builder_t;
+
 
 list_t *list_list(void *, ...);
 list_t *list_append(list_t *, list_t *);
@@ -25,6 +31,10 @@ size_t list_length(const list_t *);
 void list_free(list_t **);
 void list_map(list_t *, void (void **, void *), void *);
 list_t *list_reverse(list_t *);
+list_t *list_sort(list_t *, int (const void *, const void *));
+void list_binit(list_builder_t *);
+void list_baddtail(list_builder_t *, void *);
+list_t *list_bfinish(list_builder_t *);
 
 
 /* iterates for each node in list */
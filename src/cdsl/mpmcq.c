@@ -0,0 +1,270 @@
+/*
+ *  bounded MPMC queue (cdsl)
+ */
+
+#include <limits.h>    /* ULONG_MAX, _POSIX_C_SOURCE */
+#include <stddef.h>    /* size_t, NULL */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_ALLOC, MEM_FREE */
+#include "mpmcq.h"
+
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 199309L
+#include <sched.h>    /* sched_yield */
+#define YIELD() sched_yield()
+#else    /* no way to yield; waiting spins */
+#define YIELD() ((void)0)
+#endif    /* _POSIX_C_SOURCE */
+
+
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define ATOMIC(p)       ((_Atomic unsigned long *)(p))
+#define LOAD(p)         atomic_load_explicit(ATOMIC(p), memory_order_acquire)
+#define RLOAD(p)        atomic_load_explicit(ATOMIC(p), memory_order_relaxed)
+#define STORE(p, v)     atomic_store_explicit(ATOMIC(p), (v), memory_order_release)
+#define CAS(p, e, d)    atomic_compare_exchange_weak_explicit(ATOMIC(p), (e), (d),             \
+                                                              memory_order_relaxed,            \
+                                                              memory_order_relaxed)
+#elif defined(__ATOMIC_ACQ_REL)    /* gcc built-ins */
+#define LOAD(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RLOAD(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STORE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CAS(p, e, d)    __atomic_compare_exchange_n((p), (e), (d), 1, __ATOMIC_RELAXED,        \
+                                                    __ATOMIC_RELAXED)
+#else    /* no atomic operations; mpmcq_*() are not thread-safe */
+#define LOAD(p)         (*(p))
+#define RLOAD(p)        (*(p))
+#define STORE(p, v)     (*(p) = (v))
+#define CAS(p, e, d)    (*(p) = (d), 1)
+#endif    /* __STDC_VERSION__ */
+
+#define CACHELINE 64    /* assumed size of cache line */
+#define SPINMAX   10    /* log2 of max number of spins before yielding */
+
+#define DIFF(x, y) ((long)((x) - (y)))    /* signed distance between indices */
+
+
+/*
+ *  cell
+ *
+ *  seq tells the state of a cell for the index i that maps to it: seq == i if it is free for a
+ *  producer with i, and seq == i+1 if it holds data for a consumer with i. A consumer sets seq to
+ *  i+cap to free the cell for the next round.
+ */
+struct cell {
+    unsigned long seq;    /* sequence number */
+    void *data;           /* data */
+};
+
+
+/*
+ *  bounded MPMC queue
+ *
+ *  Producers and consumers claim indices by compare-and-swap on tail and head, respectively, and
+ *  then hand over a cell through its sequence number. tail and head are kept on separate cache
+ *  lines to avoid false sharing between producers and consumers.
+ */
+struct mpmcq_t {
+    unsigned long tail;                                   /* next index to push */
+    char pad1[CACHELINE - sizeof(unsigned long)];
+    unsigned long head;                                   /* next index to pop */
+    char pad2[CACHELINE - sizeof(unsigned long)];
+    unsigned long mask;                                   /* capacity - 1 */
+    struct cell *cell;                                    /* cells */
+};
+
+
+/*
+ *  waits before retrying
+ *
+ *  Spins for an exponentially growing while, and then yields the processor if possible.
+ */
+static void backoff(int *n)
+{
+    volatile unsigned long i;
+
+    if (*n < SPINMAX) {
+        for (i = 0; i < (1UL << *n); i++)
+            continue;
+        (*n)++;
+    } else
+        YIELD();
+}
+
+
+/*
+ *  creates a bounded MPMC queue
+ */
+mpmcq_t *(mpmcq_new)(size_t cap)
+{
+    unsigned long i, n;
+    mpmcq_t *q;
+
+    assert(cap > 0 && cap <= ULONG_MAX/2 + 1);
+
+    for (n = 2; n < cap; n <<= 1)
+        continue;
+    assert(n <= (size_t)-1 / sizeof(*q->cell));
+
+    MEM_NEW(q);
+    q->cell = MEM_ALLOC(n * sizeof(*q->cell));
+    for (i = 0; i < n; i++)
+        q->cell[i].seq = i;
+    q->mask = n - 1;
+    q->head = q->tail = 0;
+
+    return q;
+}
+
+
+/*
+ *  destroys a bounded MPMC queue
+ */
+void (mpmcq_free)(mpmcq_t **pq)
+{
+    assert(pq);
+    assert(*pq);
+
+    MEM_FREE((*pq)->cell);
+    MEM_FREE(*pq);
+}
+
+
+/*
+ *  returns the capacity of a bounded MPMC queue
+ */
+size_t (mpmcq_cap)(const mpmcq_t *q)
+{
+    assert(q);
+
+    return q->mask + 1;
+}
+
+
+/*
+ *  pushes many data into a bounded MPMC queue without waiting
+ *
+ *  Claims as many consecutive free cells as possible by a single compare-and-swap on tail. A cell
+ *  seen free for index i cannot be taken by others until tail passes i, which the swap prevents.
+ */
+size_t (mpmcq_pushv)(mpmcq_t *q, void *const *v, size_t n)
+{
+    size_t i, k;
+    unsigned long t;
+    long d;
+
+    assert(q);
+    assert(v || n == 0);
+
+    if (n == 0)
+        return 0;
+
+    t = RLOAD(&q->tail);
+    while (1) {
+        for (k = 0; k < n; k++)
+            if (LOAD(&q->cell[(t+k) & q->mask].seq) != t+k)
+                break;
+        if (k > 0) {
+            if (CAS(&q->tail, &t, t+k))
+                break;
+        } else if ((d = DIFF(LOAD(&q->cell[t & q->mask].seq), t)) < 0)
+            return 0;    /* full */
+        else if (d > 0)
+            t = RLOAD(&q->tail);
+    }
+
+    for (i = 0; i < k; i++) {
+        q->cell[(t+i) & q->mask].data = v[i];
+        STORE(&q->cell[(t+i) & q->mask].seq, t+i+1);
+    }
+
+    return k;
+}
+
+
+/*
+ *  pops many data from a bounded MPMC queue without waiting
+ */
+size_t (mpmcq_popv)(mpmcq_t *q, void **v, size_t n)
+{
+    size_t i, k;
+    unsigned long h;
+    long d;
+
+    assert(q);
+    assert(v || n == 0);
+
+    if (n == 0)
+        return 0;
+
+    h = RLOAD(&q->head);
+    while (1) {
+        for (k = 0; k < n; k++)
+            if (LOAD(&q->cell[(h+k) & q->mask].seq) != h+k+1)
+                break;
+        if (k > 0) {
+            if (CAS(&q->head, &h, h+k))
+                break;
+        } else if ((d = DIFF(LOAD(&q->cell[h & q->mask].seq), h+1)) < 0)
+            return 0;    /* empty */
+        else if (d > 0)
+            h = RLOAD(&q->head);
+    }
+
+    for (i = 0; i < k; i++) {
+        v[i] = q->cell[(h+i) & q->mask].data;
+        STORE(&q->cell[(h+i) & q->mask].seq, h+i+q->mask+1);
+    }
+
+    return k;
+}
+
+
+/*
+ *  pushes data into a bounded MPMC queue without waiting
+ */
+int (mpmcq_push)(mpmcq_t *q, void *data)
+{
+    return (mpmcq_pushv(q, &data, 1) == 1);
+}
+
+
+/*
+ *  pops data from a bounded MPMC queue without waiting
+ */
+int (mpmcq_pop)(mpmcq_t *q, void **pdata)
+{
+    assert(pdata);
+
+    return (mpmcq_popv(q, pdata, 1) == 1);
+}
+
+
+/*
+ *  pushes data into a bounded MPMC queue, waiting while it is full
+ */
+void (mpmcq_pushwait)(mpmcq_t *q, void *data)
+{
+    int n = 0;
+
+    while (mpmcq_pushv(q, &data, 1) == 0)
+        backoff(&n);
+}
+
+
+/*
+ *  pops data from a bounded MPMC queue, waiting while it is empty
+ */
+void *(mpmcq_popwait)(mpmcq_t *q)
+{
+    int n = 0;
+    void *data;
+
+    while (mpmcq_popv(q, &data, 1) == 0)
+        backoff(&n);
+
+    return data;
+}
+
+/* end of mpmcq.c */
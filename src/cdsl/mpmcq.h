@@ -0,0 +1,28 @@
+/*
+ *  bounded MPMC queue (cdsl)
+ */
+
+#ifndef MPMCQ_H
+#define MPMCQ_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* bounded MPMC queue */
+typedef struct mpmcq_t mpmcq_t;
+
+
+mpmcq_t *mpmcq_new(size_t);
+void mpmcq_free(mpmcq_t **);
+size_t mpmcq_cap(const mpmcq_t *);
+int mpmcq_push(mpmcq_t *, void *);
+int mpmcq_pop(mpmcq_t *, void **);
+size_t mpmcq_pushv(mpmcq_t *, void *const *, size_t);
+size_t mpmcq_popv(mpmcq_t *, void **, size_t);
+void mpmcq_pushwait(mpmcq_t *, void *);
+void *mpmcq_popwait(mpmcq_t *);
+
+
+#endif    /* MPMCQ_H */
+
+/* end of mpmcq.h */
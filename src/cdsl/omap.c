@@ -0,0 +1,790 @@
+/*
+ *  ordered map (cdsl)
+ */
+
+#include <stddef.h>    /* size_t, NULL */
+#include <string.h>    /* memcpy, memmove */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_ALLOC, MEM_FREE */
+#include "omap.h"
+
+
+#define MAXKEY 32                   /* max number of keys in node */
+#define MINKEY ((MAXKEY-1) / 2)     /* min number of keys in node other than root */
+
+#define LEAF(p)  ((struct leaf *)(p))     /* node to leaf */
+#define INNER(p) ((struct inner *)(p))    /* node to inner node */
+
+
+/*
+ *  node; common part of leaves and inner nodes
+ *
+ *  Keys in a node are kept in an array of their own, apart from values or children, so that a
+ *  binary search over MAXKEY keys touches only 4 cache lines of 64 bytes with 64-bit pointers.
+ */
+struct node {
+    int n;                       /* number of keys */
+    int leaf;                    /* true if leaf */
+    const void *key[MAXKEY];     /* keys */
+};
+
+/*
+ *  leaf
+ */
+struct leaf {
+    struct node h;                /* common part */
+    void *value[MAXKEY];          /* values */
+    struct leaf *prev, *next;     /* neighbor leaves */
+};
+
+/*
+ *  inner node
+ *
+ *  key[i] is the smallest key in the subtree of child[i+1]; it always points to a key stored in a
+ *  leaf, so that it never refers to a key removed from a map.
+ */
+struct inner {
+    struct node h;                     /* common part */
+    struct node *child[MAXKEY+1];      /* children */
+};
+
+
+/*
+ *  ordered map implemented by B+-tree
+ *
+ *  All key-value pairs are stored in leaves that are linked in key order, which makes traversal
+ *  and range scans sequential. timestamp is increased whenever a map is modified by omap_put() or
+ *  omap_remove(); it prevents a user-defined function invoked by omap_map() from modifying a map
+ *  during traversal and detects use of a cursor after modification.
+ */
+struct omap_t {
+    int (*cmp)(const void *, const void *);    /* comparison function */
+    struct node *root;                         /* root node; null if empty */
+    size_t length;                             /* number of key-value pairs */
+    unsigned timestamp;                        /* number of modification to map */
+};
+
+
+/*
+ *  finds the first key not less than a given key in a node
+ */
+static int lbound(const omap_t *omap, const struct node *p, const void *key)
+{
+    int lo = 0, hi = p->n, m;
+
+    while (lo < hi) {
+        m = lo + (hi-lo)/2;
+        if (omap->cmp(p->key[m], key) < 0)
+            lo = m + 1;
+        else
+            hi = m;
+    }
+
+    return lo;
+}
+
+
+/*
+ *  finds the first key greater than a given key in a node
+ */
+static int ubound(const omap_t *omap, const struct node *p, const void *key)
+{
+    int lo = 0, hi = p->n, m;
+
+    while (lo < hi) {
+        m = lo + (hi-lo)/2;
+        if (omap->cmp(key, p->key[m]) < 0)
+            hi = m;
+        else
+            lo = m + 1;
+    }
+
+    return lo;
+}
+
+
+/*
+ *  finds the leaf that would hold a key
+ */
+static struct leaf *findleaf(const omap_t *omap, const void *key)
+{
+    struct node *p = omap->root;
+
+    while (!p->leaf)
+        p = INNER(p)->child[ubound(omap, p, key)];
+
+    return LEAF(p);
+}
+
+
+/*
+ *  returns the smallest key in a subtree
+ */
+static const void *minkey(const struct node *p)
+{
+    while (!p->leaf)
+        p = INNER(p)->child[0];
+
+    return p->key[0];
+}
+
+
+/*
+ *  allocates a leaf
+ */
+static struct leaf *newleaf(void)
+{
+    struct leaf *l;
+
+    MEM_NEW(l);
+    l->h.n = 0;
+    l->h.leaf = 1;
+    l->prev = l->next = NULL;
+
+    return l;
+}
+
+
+/*
+ *  allocates an inner node
+ */
+static struct inner *newinner(void)
+{
+    struct inner *in;
+
+    MEM_NEW(in);
+    in->h.n = 0;
+    in->h.leaf = 0;
+
+    return in;
+}
+
+
+/*
+ *  inserts a key-value pair into a leaf with room
+ */
+static void leafins(struct leaf *l, int i, const void *key, void *value)
+{
+    memmove(l->h.key+i+1, l->h.key+i, (l->h.n-i)*sizeof(*l->h.key));
+    memmove(l->value+i+1, l->value+i, (l->h.n-i)*sizeof(*l->value));
+    l->h.key[i] = key;
+    l->value[i] = value;
+    l->h.n++;
+}
+
+
+/*
+ *  inserts a key and its right child into an inner node with room
+ */
+static void innerins(struct inner *in, int i, const void *key, struct node *r)
+{
+    memmove(in->h.key+i+1, in->h.key+i, (in->h.n-i)*sizeof(*in->h.key));
+    memmove(in->child+i+2, in->child+i+1, (in->h.n-i)*sizeof(*in->child));
+    in->h.key[i] = key;
+    in->child[i+1] = r;
+    in->h.n++;
+}
+
+
+/*
+ *  inserts a key-value pair into a subtree
+ *
+ *  If the root of the subtree splits, insert() returns the new right sibling and sets *psep to the
+ *  smallest key in it; it returns a null pointer otherwise.
+ */
+static struct node *insert(omap_t *omap, struct node *p, const void *key, void *value,
+                           void **pprev, const void **psep)
+{
+    int i;
+    const void *sep;
+    struct node *r;
+
+    if (p->leaf) {
+        struct leaf *l = LEAF(p), *nl;
+
+        i = lbound(omap, p, key);
+        if (i < p->n && omap->cmp(key, p->key[i]) == 0) {    /* key found */
+            *pprev = l->value[i];
+            l->value[i] = value;
+            return NULL;
+        }
+        omap->length++;
+        if (p->n < MAXKEY) {
+            leafins(l, i, key, value);
+            return NULL;
+        }
+
+        nl = newleaf();    /* splits full leaf */
+        nl->h.n = MAXKEY - MAXKEY/2;
+        memcpy(nl->h.key, p->key+MAXKEY/2, nl->h.n*sizeof(*p->key));
+        memcpy(nl->value, l->value+MAXKEY/2, nl->h.n*sizeof(*l->value));
+        p->n = MAXKEY/2;
+        nl->prev = l;
+        nl->next = l->next;
+        if (l->next)
+            l->next->prev = nl;
+        l->next = nl;
+        if (i <= MAXKEY/2)
+            leafins(l, i, key, value);
+        else
+            leafins(nl, i-MAXKEY/2, key, value);
+        *psep = nl->h.key[0];
+
+        return &nl->h;
+    } else {
+        struct inner *in = INNER(p), *ni;
+
+        i = ubound(omap, p, key);
+        if ((r = insert(omap, in->child[i], key, value, pprev, &sep)) == NULL)
+            return NULL;
+        if (p->n < MAXKEY) {
+            innerins(in, i, sep, r);
+            return NULL;
+        }
+
+        ni = newinner();    /* splits full inner node; key[MAXKEY/2] goes up */
+        ni->h.n = MAXKEY - MAXKEY/2 - 1;
+        memcpy(ni->h.key, p->key+MAXKEY/2+1, ni->h.n*sizeof(*p->key));
+        memcpy(ni->child, in->child+MAXKEY/2+1, (ni->h.n+1)*sizeof(*in->child));
+        *psep = p->key[MAXKEY/2];
+        p->n = MAXKEY/2;
+        if (i <= MAXKEY/2)
+            innerins(in, i, sep, r);
+        else
+            innerins(ni, i-MAXKEY/2-1, sep, r);
+
+        return &ni->h;
+    }
+}
+
+
+/*
+ *  merges the j+1-th child of an inner node into the j-th child
+ */
+static void merge(struct inner *in, int j)
+{
+    struct node *l = in->child[j], *r = in->child[j+1];
+
+    if (l->leaf) {
+        memcpy(l->key+l->n, r->key, r->n*sizeof(*r->key));
+        memcpy(LEAF(l)->value+l->n, LEAF(r)->value, r->n*sizeof(*LEAF(r)->value));
+        l->n += r->n;
+        LEAF(l)->next = LEAF(r)->next;
+        if (LEAF(r)->next)
+            LEAF(r)->next->prev = LEAF(l);
+    } else {
+        l->key[l->n] = in->h.key[j];
+        memcpy(l->key+l->n+1, r->key, r->n*sizeof(*r->key));
+        memcpy(INNER(l)->child+l->n+1, INNER(r)->child, (r->n+1)*sizeof(*INNER(r)->child));
+        l->n += r->n + 1;
+    }
+    MEM_FREE(r);
+
+    memmove(in->h.key+j, in->h.key+j+1, (in->h.n-j-1)*sizeof(*in->h.key));
+    memmove(in->child+j+1, in->child+j+2, (in->h.n-j-1)*sizeof(*in->child));
+    in->h.n--;
+}
+
+
+/*
+ *  restores the i-th child of an inner node that has too few keys
+ *
+ *  The child borrows a key from a sibling with enough keys, or is merged with a sibling.
+ */
+static void fix(struct inner *in, int i)
+{
+    struct node *p = in->child[i], *s;
+
+    if (i > 0 && (s = in->child[i-1])->n > MINKEY) {    /* borrows from left sibling */
+        memmove(p->key+1, p->key, p->n*sizeof(*p->key));
+        if (p->leaf) {
+            memmove(LEAF(p)->value+1, LEAF(p)->value, p->n*sizeof(*LEAF(p)->value));
+            p->key[0] = s->key[s->n-1];
+            LEAF(p)->value[0] = LEAF(s)->value[s->n-1];
+            in->h.key[i-1] = p->key[0];
+        } else {
+            memmove(INNER(p)->child+1, INNER(p)->child, (p->n+1)*sizeof(*INNER(p)->child));
+            p->key[0] = in->h.key[i-1];
+            INNER(p)->child[0] = INNER(s)->child[s->n];
+            in->h.key[i-1] = s->key[s->n-1];
+        }
+        p->n++;
+        s->n--;
+    } else if (i < in->h.n && (s = in->child[i+1])->n > MINKEY) {    /* borrows from right */
+        if (p->leaf) {
+            p->key[p->n] = s->key[0];
+            LEAF(p)->value[p->n] = LEAF(s)->value[0];
+            memmove(LEAF(s)->value, LEAF(s)->value+1, (s->n-1)*sizeof(*LEAF(s)->value));
+            memmove(s->key, s->key+1, (s->n-1)*sizeof(*s->key));
+            in->h.key[i] = s->key[0];
+        } else {
+            p->key[p->n] = in->h.key[i];
+            INNER(p)->child[p->n+1] = INNER(s)->child[0];
+            in->h.key[i] = s->key[0];
+            memmove(s->key, s->key+1, (s->n-1)*sizeof(*s->key));
+            memmove(INNER(s)->child, INNER(s)->child+1, s->n*sizeof(*INNER(s)->child));
+        }
+        p->n++;
+        s->n--;
+    } else
+        merge(in, (i > 0)? i-1: i);
+}
+
+
+/*
+ *  removes a key from a subtree
+ *
+ *  If the key removed was the smallest in the subtree of a child other than the first, the key
+ *  for the child in its parent is replaced; keys in inner nodes thus never refer to a removed key
+ *  that a user program may have deallocated.
+ */
+static int erase(omap_t *omap, struct node *p, const void *key, void **pvalue)
+{
+    int i;
+
+    if (p->leaf) {
+        struct leaf *l = LEAF(p);
+
+        i = lbound(omap, p, key);
+        if (i == p->n || omap->cmp(key, p->key[i]) != 0)
+            return 0;
+        *pvalue = l->value[i];
+        memmove(p->key+i, p->key+i+1, (p->n-i-1)*sizeof(*p->key));
+        memmove(l->value+i, l->value+i+1, (p->n-i-1)*sizeof(*l->value));
+        p->n--;
+        omap->length--;
+    } else {
+        struct inner *in = INNER(p);
+
+        i = ubound(omap, p, key);
+        if (!erase(omap, in->child[i], key, pvalue))
+            return 0;
+        if (i > 0 && omap->cmp(p->key[i-1], key) == 0)
+            p->key[i-1] = minkey(in->child[i]);
+        if (in->child[i]->n < MINKEY)
+            fix(in, i);
+    }
+
+    return 1;
+}
+
+
+/*
+ *  destroys a subtree
+ */
+static void destroy(struct node *p)
+{
+    int i;
+
+    if (!p->leaf)
+        for (i = 0; i <= p->n; i++)
+            destroy(INNER(p)->child[i]);
+    MEM_FREE(p);
+}
+
+
+/*
+ *  creates an ordered map
+ */
+omap_t *(omap_new)(int cmp(const void *, const void *))
+{
+    omap_t *omap;
+
+    assert(cmp);
+
+    MEM_NEW(omap);
+    omap->cmp = cmp;
+    omap->root = NULL;
+    omap->length = 0;
+    omap->timestamp = 0;
+
+    return omap;
+}
+
+
+/*
+ *  creates an ordered map from key-value pairs sorted by keys
+ *
+ *  Nodes of each level are built from left to right with pairs or children distributed evenly, so
+ *  that every node but the root has at least MINKEY keys; it takes a linear time.
+ */
+omap_t *(omap_build)(void *const *v, size_t n, int cmp(const void *, const void *))
+{
+    size_t i, j, k, m, cnt, per, rem;
+    struct node **lv;
+    omap_t *omap;
+
+    assert(v || n == 0);
+
+    omap = omap_new(cmp);
+    if (n == 0)
+        return omap;
+
+    for (i = 1; i < n; i++)
+        assert(cmp(v[2*(i-1)], v[2*i]) < 0);
+
+    cnt = (n + MAXKEY-1) / MAXKEY;    /* number of leaves */
+    lv = MEM_ALLOC(cnt * sizeof(*lv));
+    per = n / cnt;
+    rem = n % cnt;
+    for (i = j = 0; i < cnt; i++) {
+        struct leaf *l = newleaf();
+        l->h.n = (int)(per + (i < rem));
+        for (k = 0; k < (size_t)l->h.n; k++, j++) {
+            l->h.key[k] = v[2*j];
+            l->value[k] = v[2*j+1];
+        }
+        if (i > 0) {
+            l->prev = LEAF(lv[i-1]);
+            LEAF(lv[i-1])->next = l;
+        }
+        lv[i] = &l->h;
+    }
+
+    while (cnt > 1) {    /* builds upper levels */
+        m = (cnt + MAXKEY) / (MAXKEY+1);    /* number of inner nodes */
+        per = cnt / m;
+        rem = cnt % m;
+        for (i = j = 0; i < m; i++) {
+            struct inner *in = newinner();
+            in->h.n = (int)(per + (i < rem)) - 1;
+            in->child[0] = lv[j++];
+            for (k = 0; k < (size_t)in->h.n; k++, j++) {
+                in->h.key[k] = minkey(lv[j]);
+                in->child[k+1] = lv[j];
+            }
+            lv[i] = &in->h;
+        }
+        cnt = m;
+    }
+
+    omap->root = lv[0];
+    omap->length = n;
+    MEM_FREE(lv);
+
+    return omap;
+}
+
+
+/*
+ *  destroys an ordered map
+ */
+void (omap_free)(omap_t **pomap)
+{
+    assert(pomap);
+    assert(*pomap);
+
+    if ((*pomap)->root)
+        destroy((*pomap)->root);
+    MEM_FREE(*pomap);
+}
+
+
+/*
+ *  returns the length of an ordered map
+ */
+size_t (omap_length)(const omap_t *omap)
+{
+    assert(omap);
+
+    return omap->length;
+}
+
+
+/*
+ *  puts a value for a key to an ordered map
+ */
+void *(omap_put)(omap_t *omap, const void *key, void *value)
+{
+    const void *sep;
+    void *prev;
+    struct node *r;
+    struct inner *in;
+
+    assert(omap);
+    assert(key);
+
+    prev = NULL;
+    if (!omap->root) {
+        omap->root = &newleaf()->h;
+        omap->root->key[0] = key;
+        LEAF(omap->root)->value[0] = value;
+        omap->root->n = 1;
+        omap->length = 1;
+    } else if ((r = insert(omap, omap->root, key, value, &prev, &sep)) != NULL) {
+        in = newinner();    /* grows tree */
+        in->h.n = 1;
+        in->h.key[0] = sep;
+        in->child[0] = omap->root;
+        in->child[1] = r;
+        omap->root = &in->h;
+    }
+    omap->timestamp++;    /* map modified */
+
+    return prev;
+}
+
+
+/*
+ *  gets a value for a key from an ordered map
+ */
+void *(omap_get)(const omap_t *omap, const void *key)
+{
+    int i;
+    struct leaf *l;
+
+    assert(omap);
+    assert(key);
+
+    if (!omap->root)
+        return NULL;
+    l = findleaf(omap, key);
+    i = lbound(omap, &l->h, key);
+
+    return (i < l->h.n && omap->cmp(key, l->h.key[i]) == 0)? l->value[i]: NULL;
+}
+
+
+/*
+ *  removes a key-value pair from an ordered map
+ */
+void *(omap_remove)(omap_t *omap, const void *key)
+{
+    void *value;
+    struct node *p;
+
+    assert(omap);
+    assert(key);
+
+    omap->timestamp++;    /* map modified */
+
+    value = NULL;
+    if (!omap->root || !erase(omap, omap->root, key, &value))
+        return NULL;
+
+    p = omap->root;
+    if (p->n == 0) {    /* shrinks tree */
+        omap->root = (p->leaf)? NULL: INNER(p)->child[0];
+        MEM_FREE(p);
+    }
+
+    return value;
+}
+
+
+/*
+ *  calls a user-provided function for each key-value pair in an ordered map in key order
+ */
+void (omap_map)(omap_t *omap, void apply(const void *key, void **value, void *cl), void *cl)
+{
+    omap_range(omap, NULL, NULL, apply, cl);
+}
+
+
+/*
+ *  calls a user-provided function for each key-value pair in a range of keys
+ *
+ *  As in omap_map(), timestamp is checked to prevent a user-provided function from modifying a
+ *  map.
+ */
+void (omap_range)(omap_t *omap, const void *lo, const void *hi,
+                  void apply(const void *key, void **value, void *cl), void *cl)
+{
+    int i;
+#ifndef NDEBUG
+    unsigned stamp;    /* used only by assert() */
+#endif    /* NDEBUG */
+    struct leaf *l;
+
+    assert(omap);
+    assert(apply);
+
+    if (!omap->root)
+        return;
+
+#ifndef NDEBUG
+    stamp = omap->timestamp;
+#endif    /* NDEBUG */
+    if (lo) {
+        l = findleaf(omap, lo);
+        i = lbound(omap, &l->h, lo);
+    } else {
+        l = findleaf(omap, minkey(omap->root));
+        i = 0;
+    }
+    for (; l; l = l->next, i = 0)
+        for (; i < l->h.n; i++) {
+            if (hi && omap->cmp(l->h.key[i], hi) >= 0)
+                return;
+            apply(l->h.key[i], &l->value[i], cl);
+            assert(omap->timestamp == stamp);
+        }
+}
+
+
+/*
+ *  converts an ordered map to an array in key order
+ */
+void **(omap_toarray)(const omap_t *omap, void *end)
+{
+    int i;
+    size_t j;
+    void **array;
+    struct leaf *l;
+
+    assert(omap);
+
+    array = MEM_ALLOC((2*omap->length + 1) * sizeof(*array));
+
+    j = 0;
+    if (omap->root)
+        for (l = findleaf(omap, minkey(omap->root)); l; l = l->next)
+            for (i = 0; i < l->h.n; i++) {
+                array[j++] = (void *)l->h.key[i];    /* cast removes constness */
+                array[j++] = l->value[i];
+            }
+    array[j] = end;
+
+    return array;
+}
+
+
+/*
+ *  sets a cursor to the pair with the smallest key
+ */
+int (omap_first)(const omap_t *omap, omap_cursor_t *c)
+{
+    assert(omap);
+    assert(c);
+
+    c->omap = omap;
+    c->stamp = omap->timestamp;
+    c->node = (omap->root)? findleaf(omap, minkey(omap->root)): NULL;
+    c->i = 0;
+
+    return (c->node != NULL);
+}
+
+
+/*
+ *  sets a cursor to the pair with the largest key
+ */
+int (omap_last)(const omap_t *omap, omap_cursor_t *c)
+{
+    struct node *p;
+
+    assert(omap);
+    assert(c);
+
+    c->omap = omap;
+    c->stamp = omap->timestamp;
+    c->node = NULL;
+    if ((p = omap->root) != NULL) {
+        while (!p->leaf)
+            p = INNER(p)->child[p->n];
+        c->node = p;
+        c->i = p->n - 1;
+    }
+
+    return (c->node != NULL);
+}
+
+
+/*
+ *  sets a cursor to the pair with the smallest key not less than a given key
+ */
+int (omap_seek)(const omap_t *omap, const void *key, omap_cursor_t *c)
+{
+    struct leaf *l;
+
+    assert(omap);
+    assert(key);
+    assert(c);
+
+    c->omap = omap;
+    c->stamp = omap->timestamp;
+    c->node = NULL;
+    if (omap->root) {
+        l = findleaf(omap, key);
+        c->i = lbound(omap, &l->h, key);
+        if (c->i == l->h.n) {
+            l = l->next;
+            c->i = 0;
+        }
+        c->node = l;
+    }
+
+    return (c->node != NULL);
+}
+
+
+/*
+ *  moves a cursor to the next pair
+ */
+int (omap_next)(omap_cursor_t *c)
+{
+    struct leaf *l;
+
+    assert(c);
+    assert(c->omap->timestamp == c->stamp);
+
+    if ((l = c->node) == NULL)
+        return 0;
+    if (++c->i == l->h.n) {
+        c->node = l->next;
+        c->i = 0;
+    }
+
+    return (c->node != NULL);
+}
+
+
+/*
+ *  moves a cursor to the previous pair
+ */
+int (omap_prev)(omap_cursor_t *c)
+{
+    struct leaf *l;
+
+    assert(c);
+    assert(c->omap->timestamp == c->stamp);
+
+    if ((l = c->node) == NULL)
+        return 0;
+    if (c->i-- == 0) {
+        c->node = l = l->prev;
+        if (l)
+            c->i = l->h.n - 1;
+    }
+
+    return (c->node != NULL);
+}
+
+
+/*
+ *  returns the key of a pair at a cursor
+ */
+const void *(omap_key)(const omap_cursor_t *c)
+{
+    assert(c);
+    assert(c->node);
+    assert(c->omap->timestamp == c->stamp);
+
+    return LEAF(c->node)->h.key[c->i];
+}
+
+
+/*
+ *  returns the value of a pair at a cursor
+ */
+void *(omap_value)(const omap_cursor_t *c)
+{
+    assert(c);
+    assert(c->node);
+    assert(c->omap->timestamp == c->stamp);
+
+    return LEAF(c->node)->value[c->i];
+}
+
+/* end of omap.c */
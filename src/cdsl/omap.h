@@ -0,0 +1,45 @@
+/*
+ *  ordered map (cdsl)
+ */
+
+#ifndef OMAP_H
+#define OMAP_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* ordered map */
+typedef struct omap_t omap_t;
+
+/* cursor to key-value pair in ordered map */
+typedef struct omap_cursor_t {
+    const omap_t *omap;    /* map traversed */
+    void *node;            /* leaf holding pair; null if past end */
+    int i;                 /* index of pair in leaf */
+    unsigned stamp;        /* timestamp of map when cursor set */
+} omap_cursor_t;
+
+
+omap_t *omap_new(int (const void *, const void *));
+omap_t *omap_build(void *const *, size_t, int (const void *, const void *));
+void omap_free(omap_t **);
+size_t omap_length(const omap_t *);
+void *omap_put(omap_t *, const void *, void *);
+void *omap_get(const omap_t *, const void *);
+void *omap_remove(omap_t *, const void *);
+void omap_map(omap_t *, void (const void *, void **, void *), void *);
+void omap_range(omap_t *, const void *, const void *, void (const void *, void **, void *),
+                void *);
+void **omap_toarray(const omap_t *, void *);
+int omap_first(const omap_t *, omap_cursor_t *);
+int omap_last(const omap_t *, omap_cursor_t *);
+int omap_seek(const omap_t *, const void *, omap_cursor_t *);
+int omap_next(omap_cursor_t *);
+int omap_prev(omap_cursor_t *);
+const void *omap_key(const omap_cursor_t *);
+void *omap_value(const omap_cursor_t *);
+
+
+#endif    /* OMAP_H */
+
+/* end of omap.h */
@@ -0,0 +1,610 @@
+/*
+ *  work-stealing thread pool (cdsl)
+ */
+
+#include <limits.h>    /* _POSIX_C_SOURCE */
+#include <stddef.h>    /* size_t, NULL */
+#include <stdlib.h>    /* malloc, free */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_ALLOC, MEM_FREE */
+#include "pool.h"
+
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 199506L &&                              \
+    ((__STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)) || defined(__ATOMIC_ACQ_REL))
+#define THREAD    /* workers run as POSIX threads */
+#include <pthread.h>    /* pthread_*, PTHREAD_* */
+#include <sched.h>      /* sched_yield */
+#endif    /* _POSIX_C_SOURCE */
+
+
+#ifdef THREAD
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define RLX             memory_order_relaxed
+#define ACQ             memory_order_acquire
+#define REL             memory_order_release
+#define SEQ             memory_order_seq_cst
+#define ALONG(p)        ((_Atomic long *)(p))
+#define APTR(p)         ((void *_Atomic *)(p))
+#define LOAD(p, o)      atomic_load_explicit(ALONG(p), (o))
+#define STORE(p, v, o)  atomic_store_explicit(ALONG(p), (v), (o))
+#define ADD(p, v)       atomic_fetch_add_explicit(ALONG(p), (v), memory_order_seq_cst)
+#define CAS(p, e, d)    atomic_compare_exchange_strong_explicit(ALONG(p), (e), (d),                \
+                                                                memory_order_seq_cst,              \
+                                                                memory_order_relaxed)
+#define PLOAD(p)        atomic_load_explicit(APTR(p), memory_order_relaxed)
+#define PSTORE(p, v)    atomic_store_explicit(APTR(p), (v), memory_order_relaxed)
+#define FENCE()         atomic_thread_fence(memory_order_seq_cst)
+#else    /* gcc built-ins */
+#define RLX             __ATOMIC_RELAXED
+#define ACQ             __ATOMIC_ACQUIRE
+#define REL             __ATOMIC_RELEASE
+#define SEQ             __ATOMIC_SEQ_CST
+#define LOAD(p, o)      __atomic_load_n((p), (o))
+#define STORE(p, v, o)  __atomic_store_n((p), (v), (o))
+#define ADD(p, v)       __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define CAS(p, e, d)    __atomic_compare_exchange_n((p), (e), (d), 0, __ATOMIC_SEQ_CST,            \
+                                                    __ATOMIC_RELAXED)
+#define PLOAD(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#define PSTORE(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define FENCE()         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif    /* __STDC_VERSION__ */
+#endif    /* THREAD */
+
+#define CACHELINE 64      /* assumed size of cache line */
+#define SPINMAX   10      /* log2 of max number of spins before yielding */
+#define DEQCAP    1024    /* capacity of deque for each worker; must be power of 2 */
+#define SPLIT     8       /* number of chunks per thread when grain size not given */
+
+
+/*
+ *  parallel loop
+ */
+struct loop {
+    void (*body)(size_t, size_t, void *);    /* loop body */
+    void *cl;                                /* closure for body */
+    size_t grain;                            /* max size of chunk */
+    long pending;                            /* number of unfinished range tasks */
+};
+
+
+/*
+ *  task
+ *
+ *  A task submitted by pool_submit() runs f(arg); a task made by pool_for() has loop set and
+ *  covers [lo, hi) of the loop, splitting off its upper half to other workers while it is larger
+ *  than the grain size.
+ *
+ *  Tasks are allocated by malloc() rather than by the memory library that raises an exception on
+ *  failure; the exception library keeps one stack of handlers for all threads, thus raising in a
+ *  worker may jump into another thread. A task that cannot be allocated runs in the thread that
+ *  would queue it.
+ */
+struct task {
+    void (*f)(void *);    /* function to run */
+    void *arg;            /* argument to f */
+    struct loop *loop;    /* loop if range task */
+    size_t lo, hi;        /* range of range task */
+    struct task *next;    /* next task from outside */
+};
+
+
+#ifdef THREAD
+/*
+ *  worker
+ *
+ *  A worker has a Chase-Lev deque of fixed capacity; the worker pushes and takes tasks at bottom while
+ *  others steal at top. An index is not reduced until masked, thus bottom - top is the number of
+ *  tasks in the deque. A worker whose deque is full runs a new task itself instead of pushing it.
+ */
+struct worker {
+    long top;                                               /* next index to steal */
+    char pad1[CACHELINE - sizeof(long)];
+    long bottom;                                            /* next index to push */
+    char pad2[CACHELINE - sizeof(long)];
+    struct task **slot;                                     /* slots of deque */
+    pool_t *pool;                                           /* pool to which worker belongs */
+    unsigned long seed;                                     /* seed to choose victim */
+    pthread_t tid;                                          /* thread id */
+};
+#endif    /* THREAD */
+
+
+/*
+ *  work-stealing thread pool
+ *
+ *  Tasks submitted by threads not in the pool go through a list guarded by mutex. queued counts
+ *  tasks pushed but not taken, and tells sleeping workers that there is work to steal;
+ *  unfinished counts tasks submitted but not finished for pool_wait().
+ */
+struct pool_t {
+    int n;                        /* number of workers running */
+#ifdef THREAD
+    int nw;                       /* number of workers including ones failed to start */
+    int stop;                     /* set when workers should stop */
+    struct worker *w;             /* workers */
+    struct task *head, *tail;     /* list of tasks from outside */
+    long queued;                  /* number of tasks queued */
+    long unfinished;              /* number of tasks unfinished */
+    long sleeping;                /* number of workers sleeping */
+    pthread_key_t key;            /* key to worker of current thread */
+    pthread_mutex_t mutex;        /* mutex for list, stop and conditions */
+    pthread_cond_t work;          /* signaled when task queued */
+    pthread_cond_t done;          /* broadcast when no task unfinished */
+#endif    /* THREAD */
+};
+
+
+/*
+ *  runs a loop over a range in the calling thread
+ */
+static void serial(size_t lo, size_t hi, size_t grain, void (*body)(size_t, size_t, void *),
+                   void *cl)
+{
+    for (; hi - lo > grain; lo += grain)
+        body(lo, lo+grain, cl);
+    if (lo < hi)
+        body(lo, hi, cl);
+}
+
+
+#ifdef THREAD
+/*
+ *  waits before retrying
+ *
+ *  Spins for an exponentially growing while, and then yields the processor.
+ */
+static void backoff(int *n)
+{
+    volatile unsigned long i;
+
+    if (*n < SPINMAX) {
+        for (i = 0; i < (1UL << *n); i++)
+            continue;
+        (*n)++;
+    } else
+        sched_yield();
+}
+
+
+/*
+ *  pushes a task into the deque of a worker; called only by its owner
+ */
+static int push(struct worker *w, struct task *t)
+{
+    long b, tp;
+
+    b = LOAD(&w->bottom, RLX);
+    tp = LOAD(&w->top, ACQ);
+    if (b - tp >= DEQCAP)
+        return 0;    /* full */
+    PSTORE(&w->slot[b & (DEQCAP-1)], t);
+    STORE(&w->bottom, b+1, REL);
+
+    return 1;
+}
+
+
+/*
+ *  takes a task from the deque of a worker; called only by its owner
+ *
+ *  The owner reserves the bottom slot first; only when it is the last one does the owner race
+ *  with thieves for it by compare-and-swap on top.
+ */
+static struct task *take(struct worker *w)
+{
+    long b, tp;
+    struct task *t = NULL;
+
+    b = LOAD(&w->bottom, RLX) - 1;
+    STORE(&w->bottom, b, RLX);
+    FENCE();
+    tp = LOAD(&w->top, RLX);
+    if (tp <= b) {
+        t = PLOAD(&w->slot[b & (DEQCAP-1)]);
+        if (tp == b) {
+            if (!CAS(&w->top, &tp, tp+1))
+                t = NULL;    /* stolen */
+            STORE(&w->bottom, b+1, RLX);
+        }
+    } else
+        STORE(&w->bottom, b+1, RLX);
+
+    return t;
+}
+
+
+/*
+ *  steals a task from the deque of a worker
+ */
+static struct task *steal(struct worker *w)
+{
+    long b, tp;
+    struct task *t;
+
+    tp = LOAD(&w->top, ACQ);
+    FENCE();
+    b = LOAD(&w->bottom, ACQ);
+    if (tp >= b)
+        return NULL;    /* empty */
+    t = PLOAD(&w->slot[tp & (DEQCAP-1)]);
+
+    return (CAS(&w->top, &tp, tp+1))? t: NULL;
+}
+
+
+/*
+ *  wakes up a sleeping worker after a task queued
+ *
+ *  queued is incremented before sleeping is read, and a worker increments sleeping before reading
+ *  queued; all four accesses are sequentially consistent (an acquire load could miss the other
+ *  side's increment as in store buffering), thus either the worker sees the task or this sees the
+ *  worker, and then the mutex keeps the signal from coming before the worker waits.
+ */
+static void notify(pool_t *pool)
+{
+    ADD(&pool->queued, 1);
+    if (LOAD(&pool->sleeping, SEQ) > 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_signal(&pool->work);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+
+static void run(pool_t *, struct worker *, struct task *);
+
+
+/*
+ *  queues a task, or runs it if the deque of the current worker is full
+ */
+static void spawn(pool_t *pool, struct worker *self, struct task *t)
+{
+    ADD(&pool->unfinished, 1);
+    if (self) {
+        if (push(self, t))
+            notify(pool);
+        else
+            run(pool, self, t);
+    } else {
+        t->next = NULL;
+        pthread_mutex_lock(&pool->mutex);
+        if (pool->tail)
+            pool->tail->next = t;
+        else
+            pool->head = t;
+        pool->tail = t;
+        pthread_mutex_unlock(&pool->mutex);
+        notify(pool);
+    }
+}
+
+
+/*
+ *  runs a range task of a parallel loop
+ *
+ *  If a task for the upper half cannot be allocated, the rest of the range runs here chunk by
+ *  chunk.
+ */
+static void range(pool_t *pool, struct worker *self, struct task *t)
+{
+    size_t lo = t->lo, hi = t->hi, mid;
+    struct loop *loop = t->loop;
+    struct task *u;
+
+    while (hi - lo > loop->grain && (u = malloc(sizeof(*u))) != NULL) {
+        mid = lo + (hi-lo)/2;
+        u->f = NULL;
+        u->arg = NULL;
+        u->loop = loop;
+        u->lo = mid;
+        u->hi = hi;
+        ADD(&loop->pending, 1);
+        spawn(pool, self, u);
+        hi = mid;
+    }
+    serial(lo, hi, loop->grain, loop->body, loop->cl);
+    ADD(&loop->pending, -1);
+}
+
+
+/*
+ *  runs and frees a task taken
+ */
+static void run(pool_t *pool, struct worker *self, struct task *t)
+{
+    if (t->loop)
+        range(pool, self, t);
+    else
+        t->f(t->arg);
+    free(t);
+
+    if (ADD(&pool->unfinished, -1) == 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->done);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+
+/*
+ *  finds and runs a task
+ *
+ *  Looks into the deque of the current worker, the tasks from outside and then the deques of
+ *  other workers starting from a random one.
+ */
+static int runone(pool_t *pool, struct worker *self)
+{
+    int i, k;
+    struct task *t = NULL;
+
+    if (self)
+        t = take(self);
+    if (!t && LOAD(&pool->queued, ACQ) > 0) {
+        pthread_mutex_lock(&pool->mutex);
+        if ((t = pool->head) != NULL && (pool->head = t->next) == NULL)
+            pool->tail = NULL;
+        pthread_mutex_unlock(&pool->mutex);
+        if (!t) {
+            if (self) {
+                self->seed ^= self->seed << 13;
+                self->seed ^= self->seed >> 7;
+                self->seed ^= self->seed << 17;
+                k = self->seed % pool->nw;
+            } else
+                k = 0;
+            for (i = 0; i < pool->nw && !t; i++)
+                if (&pool->w[(k+i) % pool->nw] != self)
+                    t = steal(&pool->w[(k+i) % pool->nw]);
+        }
+    }
+    if (!t)
+        return 0;
+
+    ADD(&pool->queued, -1);
+    run(pool, self, t);
+
+    return 1;
+}
+
+
+/*
+ *  runs a worker
+ */
+static void *work(void *arg)
+{
+    int n = 0, stop = 0;
+    struct worker *self = arg;
+    pool_t *pool = self->pool;
+
+    pthread_setspecific(pool->key, self);
+    while (!stop) {
+        if (runone(pool, self))
+            n = 0;
+        else if (LOAD(&pool->queued, ACQ) > 0)
+            backoff(&n);    /* lost race for task */
+        else {
+            pthread_mutex_lock(&pool->mutex);
+            ADD(&pool->sleeping, 1);
+            while (LOAD(&pool->queued, SEQ) == 0 && !pool->stop)
+                pthread_cond_wait(&pool->work, &pool->mutex);
+            ADD(&pool->sleeping, -1);
+            stop = (pool->stop && LOAD(&pool->queued, ACQ) == 0);
+            pthread_mutex_unlock(&pool->mutex);
+        }
+    }
+
+    return NULL;
+}
+#endif    /* THREAD */
+
+
+/*
+ *  creates a work-stealing thread pool
+ *
+ *  Without POSIX threads no worker starts, and tasks run in the calling thread. Failing to start a
+ *  thread leaves the pool with fewer workers; the deque of a worker not started stays empty and is
+ *  harmlessly visited by thieves.
+ */
+pool_t *(pool_new)(int n)
+{
+    pool_t *pool;
+#ifdef THREAD
+    int i;
+#endif    /* THREAD */
+
+    assert(n >= 0);
+
+    MEM_NEW(pool);
+    pool->n = 0;
+#ifdef THREAD
+    pool->nw = n;
+    pool->w = NULL;
+    if (n == 0)
+        return pool;
+
+    assert((size_t)n <= (size_t)-1 / sizeof(*pool->w));
+    pool->w = MEM_ALLOC(n * sizeof(*pool->w));
+    for (i = 0; i < n; i++) {
+        pool->w[i].slot = MEM_ALLOC(DEQCAP * sizeof(*pool->w[i].slot));
+        pool->w[i].top = pool->w[i].bottom = 0;
+        pool->w[i].pool = pool;
+        pool->w[i].seed = i + 1;
+    }
+    pool->head = pool->tail = NULL;
+    pool->stop = 0;
+    pool->queued = pool->unfinished = pool->sleeping = 0;
+    pthread_key_create(&pool->key, NULL);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (i = 0; i < n; i++)
+        if (pthread_create(&pool->w[i].tid, NULL, work, &pool->w[i]) != 0)
+            break;
+    pool->n = i;
+#endif    /* THREAD */
+
+    return pool;
+}
+
+
+/*
+ *  destroys a work-stealing thread pool
+ */
+void (pool_free)(pool_t **ppool)
+{
+#ifdef THREAD
+    int i;
+    pool_t *pool;
+#endif    /* THREAD */
+
+    assert(ppool);
+    assert(*ppool);
+
+#ifdef THREAD
+    pool = *ppool;
+    if (pool->w) {
+        pool_wait(pool);
+        pthread_mutex_lock(&pool->mutex);
+        pool->stop = 1;
+        pthread_cond_broadcast(&pool->work);
+        pthread_mutex_unlock(&pool->mutex);
+        for (i = 0; i < pool->n; i++)
+            pthread_join(pool->w[i].tid, NULL);
+
+        pthread_cond_destroy(&pool->done);
+        pthread_cond_destroy(&pool->work);
+        pthread_mutex_destroy(&pool->mutex);
+        pthread_key_delete(pool->key);
+        for (i = 0; i < pool->nw; i++)
+            MEM_FREE(pool->w[i].slot);
+        MEM_FREE(pool->w);
+    }
+#endif    /* THREAD */
+    MEM_FREE(*ppool);
+}
+
+
+/*
+ *  returns the number of workers in a work-stealing thread pool
+ */
+int (pool_size)(const pool_t *pool)
+{
+    assert(pool);
+
+    return pool->n;
+}
+
+
+/*
+ *  submits a task to a work-stealing thread pool
+ *
+ *  A task submitted by a worker goes into its own deque, and one by other threads into the queue
+ *  shared by workers. A task that cannot be allocated runs before pool_submit() returns.
+ */
+void (pool_submit)(pool_t *pool, void (*f)(void *), void *arg)
+{
+#ifdef THREAD
+    struct task *t;
+#endif    /* THREAD */
+
+    assert(pool);
+    assert(f);
+
+    if (pool->n == 0) {
+        f(arg);
+        return;
+    }
+#ifdef THREAD
+    if ((t = malloc(sizeof(*t))) == NULL) {
+        f(arg);
+        return;
+    }
+    t->f = f;
+    t->arg = arg;
+    t->loop = NULL;
+    spawn(pool, pthread_getspecific(pool->key), t);
+#endif    /* THREAD */
+}
+
+
+/*
+ *  waits until all tasks submitted to a work-stealing thread pool finish
+ */
+void (pool_wait)(pool_t *pool)
+{
+    assert(pool);
+
+#ifdef THREAD
+    if (pool->n == 0)
+        return;
+    assert(!pthread_getspecific(pool->key));    /* would wait for itself */
+
+    pthread_mutex_lock(&pool->mutex);
+    while (LOAD(&pool->unfinished, ACQ) > 0)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+#endif    /* THREAD */
+}
+
+
+/*
+ *  runs a loop over a range in parallel using a work-stealing thread pool
+ *
+ *  The calling thread helps run tasks (not only ones from the loop) until the loop finishes,
+ *  which keeps a worker running a loop from blocking the pool.
+ */
+void (pool_for)(pool_t *pool, size_t lo, size_t hi, size_t grain,
+                void (*body)(size_t, size_t, void *), void *cl)
+{
+#ifdef THREAD
+    int n = 0;
+    struct loop loop;
+    struct task *t;
+    struct worker *self;
+#endif    /* THREAD */
+
+    assert(pool);
+    assert(body);
+    assert(lo <= hi);
+
+    if (grain == 0)
+        grain = (hi-lo) / (SPLIT * (pool->n+1));
+    if (grain == 0)
+        grain = 1;
+
+    if (pool->n == 0) {
+        serial(lo, hi, grain, body, cl);
+        return;
+    }
+#ifdef THREAD
+    if (lo == hi)
+        return;
+    if ((t = malloc(sizeof(*t))) == NULL) {
+        serial(lo, hi, grain, body, cl);
+        return;
+    }
+
+    loop.body = body;
+    loop.cl = cl;
+    loop.grain = grain;
+    loop.pending = 1;
+    t->f = NULL;
+    t->arg = NULL;
+    t->loop = &loop;
+    t->lo = lo;
+    t->hi = hi;
+    self = pthread_getspecific(pool->key);
+    spawn(pool, self, t);
+
+    while (LOAD(&loop.pending, ACQ) > 0)
+        if (runone(pool, self))
+            n = 0;
+        else
+            backoff(&n);
+#endif    /* THREAD */
+}
+
+/* end of pool.c */
@@ -0,0 +1,25 @@
+/*
+ *  work-stealing thread pool (cdsl)
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* work-stealing thread pool */
+typedef struct pool_t pool_t;
+
+
+pool_t *pool_new(int);
+void pool_free(pool_t **);
+int pool_size(const pool_t *);
+void pool_submit(pool_t *, void (*)(void *), void *);
+void pool_wait(pool_t *);
+void pool_for(pool_t *, size_t, size_t, size_t, void (*)(size_t, size_t, void *), void *);
+
+
+#endif    /* POOL_H */
+
+/* end of pool.h */
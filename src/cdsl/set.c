@@ -7,9 +7,23 @@
 
 #include "cbl/memory.h"    /* MEM_ALLOC, MEM_NEW, MEM_FREE */
 #include "cbl/assert.h"    /* assert with exception support */
+#include "pool.h"
 #include "set.h"
 
 
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define LOAD(p)     atomic_load_explicit((_Atomic int *)(p), memory_order_relaxed)
+#define STORE(p)    atomic_store_explicit((_Atomic int *)(p), 1, memory_order_relaxed)
+#elif defined(__ATOMIC_RELAXED)    /* gcc built-ins */
+#define LOAD(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STORE(p)    __atomic_store_n((p), 1, __ATOMIC_RELAXED)
+#else    /* no atomic operations; no threads run in set_pmap() */
+#define LOAD(p)     (*(p))
+#define STORE(p)    (*(p) = 1)
+#endif    /* __STDC_VERSION__ */
+
+
 #define MAX(x, y) ((x) > (y)? (x): (y))    /* returns larger of two */
 #define MIN(x, y) ((x) > (y)? (y): (x))    /* returns smaller of two */
 
@@ -317,6 +331,89 @@ void (set_map)(set_t *set, void apply(const void *member, void *cl), void *cl)
 }
 
 
+/*
+ *  arguments to set_pmap() shared by threads
+ */
+struct pmap {
+    set_t *set;                              /* set to traverse */
+    void (*apply)(const void *, void *);     /* user-provided function */
+    void *cl;                                /* passing-by argument to apply() */
+    unsigned stamp;                          /* timestamp before traversal */
+    int stop;                                /* set when modification found */
+};
+
+
+/*
+ *  checks if a set has been modified during set_pmap()
+ *
+ *  A worker cannot raise assert_exceptfail safely, thus the first thread that finds timestamp
+ *  changed sets stop to make all threads leave their ranges, and set_pmap() checks timestamp
+ *  after all threads finish.
+ */
+static int changed(struct pmap *pm)
+{
+    if (LOAD(&pm->stop))
+        return 1;
+    if (pm->set->timestamp != pm->stamp) {
+        STORE(&pm->stop);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ *  calls a user-provided function for each member in a range of buckets
+ */
+static void pmap(size_t lo, size_t hi, void *cl)
+{
+    struct pmap *pm = cl;
+    struct member *p;
+
+    if (changed(pm))
+        return;
+    for (; lo < hi; lo++)
+        for (p = pm->set->bucket[lo]; p; p = p->link) {
+            if (changed(pm))
+                return;
+            pm->apply(p->member, pm->cl);
+            if (changed(pm))
+                return;
+        }
+}
+
+
+/*
+ *  calls a user-provided function for each member in a set using threads
+ *
+ *  The buckets are divided among n threads including the calling one, using a thread pool that
+ *  lives during the call. A callback modifying the set may free a member another thread is
+ *  visiting, thus has undefined behavior; the timestamp check is only a best effort that catches
+ *  the modification reliably when a single thread runs.
+ */
+void (set_pmap)(set_t *set, void apply(const void *member, void *cl), void *cl, int n)
+{
+    pool_t *pool;
+    struct pmap pm;
+
+    assert(set);
+    assert(apply);
+    assert(n > 0);
+
+    pm.set = set;
+    pm.apply = apply;
+    pm.cl = cl;
+    pm.stamp = set->timestamp;
+    pm.stop = 0;
+
+    pool = pool_new(n - 1);
+    pool_for(pool, 0, set->size, 0, pmap, &pm);
+    pool_free(&pool);
+    assert(set->timestamp == pm.stamp);
+}
+
+
 /*
  *  converts a set to an array
  */
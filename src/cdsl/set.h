@@ -19,6 +19,7 @@ int set_member(set_t *, const void *);
 void set_put(set_t *, const void *);
 void *set_remove(set_t *, const void *);
 void set_map(set_t *, void (const void *, void *), void *);
+void set_pmap(set_t *, void (const void *, void *), void *, int);
 void **set_toarray(set_t *, void *);
 set_t *set_union(set_t *, set_t *);
 set_t *set_inter(set_t *, set_t *);
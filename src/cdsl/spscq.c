@@ -0,0 +1,227 @@
+/*
+ *  bounded SPSC queue (cdsl)
+ */
+
+#include <limits.h>    /* ULONG_MAX, _POSIX_C_SOURCE */
+#include <stddef.h>    /* size_t, NULL */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_ALLOC, MEM_FREE */
+#include "spscq.h"
+
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 199309L
+#include <sched.h>    /* sched_yield */
+#define YIELD() sched_yield()
+#else    /* no way to yield; waiting spins */
+#define YIELD() ((void)0)
+#endif    /* _POSIX_C_SOURCE */
+
+
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define ATOMIC(p)      ((_Atomic unsigned long *)(p))
+#define LOAD(p)        atomic_load_explicit(ATOMIC(p), memory_order_acquire)
+#define STORE(p, v)    atomic_store_explicit(ATOMIC(p), (v), memory_order_release)
+#elif defined(__ATOMIC_ACQ_REL)    /* gcc built-ins */
+#define LOAD(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else    /* no atomic operations; spscq_*() are not thread-safe */
+#define LOAD(p)        (*(p))
+#define STORE(p, v)    (*(p) = (v))
+#endif    /* __STDC_VERSION__ */
+
+#define CACHELINE 64    /* assumed size of cache line */
+#define SPINMAX   10    /* log2 of max number of spins before yielding */
+
+
+/*
+ *  bounded SPSC queue implemented by ring buffer
+ *
+ *  Only the producer writes tail and only the consumer writes head; each side publishes its index
+ *  with a release store after touching slots and reads the other's with an acquire load, so no
+ *  read-modify-write operation is needed. Each side also keeps a copy of the other's index and
+ *  reloads it only when the copy says the buffer is full (or empty), which keeps the cache line of
+ *  the other side from bouncing on every operation.
+ */
+struct spscq_t {
+    unsigned long head;                                      /* next index to pop */
+    unsigned long tailc;                                     /* consumer's copy of tail */
+    char pad1[CACHELINE - 2*sizeof(unsigned long)];
+    unsigned long tail;                                      /* next index to push */
+    unsigned long headc;                                     /* producer's copy of head */
+    char pad2[CACHELINE - 2*sizeof(unsigned long)];
+    unsigned long mask;                                      /* capacity - 1 */
+    void **slot;                                             /* slots */
+};
+
+
+/*
+ *  waits before retrying
+ *
+ *  Spins for an exponentially growing while, and then yields the processor if possible.
+ */
+static void backoff(int *n)
+{
+    volatile unsigned long i;
+
+    if (*n < SPINMAX) {
+        for (i = 0; i < (1UL << *n); i++)
+            continue;
+        (*n)++;
+    } else
+        YIELD();
+}
+
+
+/*
+ *  creates a bounded SPSC queue
+ */
+spscq_t *(spscq_new)(size_t cap)
+{
+    unsigned long n;
+    spscq_t *q;
+
+    assert(cap > 0 && cap <= ULONG_MAX/2 + 1);
+
+    for (n = 2; n < cap; n <<= 1)
+        continue;
+    assert(n <= (size_t)-1 / sizeof(*q->slot));
+
+    MEM_NEW(q);
+    q->slot = MEM_ALLOC(n * sizeof(*q->slot));
+    q->mask = n - 1;
+    q->head = q->tailc = q->tail = q->headc = 0;
+
+    return q;
+}
+
+
+/*
+ *  destroys a bounded SPSC queue
+ */
+void (spscq_free)(spscq_t **pq)
+{
+    assert(pq);
+    assert(*pq);
+
+    MEM_FREE((*pq)->slot);
+    MEM_FREE(*pq);
+}
+
+
+/*
+ *  returns the capacity of a bounded SPSC queue
+ */
+size_t (spscq_cap)(const spscq_t *q)
+{
+    assert(q);
+
+    return q->mask + 1;
+}
+
+
+/*
+ *  pushes many data into a bounded SPSC queue without waiting
+ */
+size_t (spscq_pushv)(spscq_t *q, void *const *v, size_t n)
+{
+    size_t i;
+    unsigned long t, room;
+
+    assert(q);
+    assert(v || n == 0);
+
+    t = q->tail;
+    room = q->mask + 1 - (t - q->headc);
+    if (room < n) {
+        q->headc = LOAD(&q->head);
+        room = q->mask + 1 - (t - q->headc);
+    }
+    if (n > room)
+        n = room;
+
+    for (i = 0; i < n; i++)
+        q->slot[(t+i) & q->mask] = v[i];
+    if (n > 0)
+        STORE(&q->tail, t+n);
+
+    return n;
+}
+
+
+/*
+ *  pops many data from a bounded SPSC queue without waiting
+ */
+size_t (spscq_popv)(spscq_t *q, void **v, size_t n)
+{
+    size_t i;
+    unsigned long h, avail;
+
+    assert(q);
+    assert(v || n == 0);
+
+    h = q->head;
+    avail = q->tailc - h;
+    if (avail < n) {
+        q->tailc = LOAD(&q->tail);
+        avail = q->tailc - h;
+    }
+    if (n > avail)
+        n = avail;
+
+    for (i = 0; i < n; i++)
+        v[i] = q->slot[(h+i) & q->mask];
+    if (n > 0)
+        STORE(&q->head, h+n);
+
+    return n;
+}
+
+
+/*
+ *  pushes data into a bounded SPSC queue without waiting
+ */
+int (spscq_push)(spscq_t *q, void *data)
+{
+    return (spscq_pushv(q, &data, 1) == 1);
+}
+
+
+/*
+ *  pops data from a bounded SPSC queue without waiting
+ */
+int (spscq_pop)(spscq_t *q, void **pdata)
+{
+    assert(pdata);
+
+    return (spscq_popv(q, pdata, 1) == 1);
+}
+
+
+/*
+ *  pushes data into a bounded SPSC queue, waiting while it is full
+ */
+void (spscq_pushwait)(spscq_t *q, void *data)
+{
+    int n = 0;
+
+    while (spscq_pushv(q, &data, 1) == 0)
+        backoff(&n);
+}
+
+
+/*
+ *  pops data from a bounded SPSC queue, waiting while it is empty
+ */
+void *(spscq_popwait)(spscq_t *q)
+{
+    int n = 0;
+    void *data;
+
+    while (spscq_popv(q, &data, 1) == 0)
+        backoff(&n);
+
+    return data;
+}
+
+/* end of spscq.c */
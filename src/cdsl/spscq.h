@@ -0,0 +1,28 @@
+/*
+ *  bounded SPSC queue (cdsl)
+ */
+
+#ifndef SPSCQ_H
+#define SPSCQ_H
+
+#include <stddef.h>    /* size_t */
+
+
+/* bounded SPSC queue */
+typedef struct spscq_t spscq_t;
+
+
+spscq_t *spscq_new(size_t);
+void spscq_free(spscq_t **);
+size_t spscq_cap(const spscq_t *);
+int spscq_push(spscq_t *, void *);
+int spscq_pop(spscq_t *, void **);
+size_t spscq_pushv(spscq_t *, void *const *, size_t);
+size_t spscq_popv(spscq_t *, void **, size_t);
+void spscq_pushwait(spscq_t *, void *);
+void *spscq_popwait(spscq_t *);
+
+
+#endif    /* SPSCQ_H */
+
+/* end of spscq.h */
@@ -2,22 +2,54 @@
  *  stack (cdsl)
  */
 
-#include <stddef.h>    /* NULL */
+#include <stddef.h>    /* NULL, size_t */
+#include <string.h>    /* memcpy */
 
 #include "cbl/assert.h"    /* assert with exception support */
-#include "cbl/memory.h"    /* MEM_NEW, MEM_FREE */
+#include "cbl/memory.h"    /* MEM_NEW, MEM_FREE, MEM_ALLOC, MEM_RESIZE */
 #include "stack.h"
 
 
-/* stack implemented by linked list */
+#define MINCAP 16    /* min capacity of stack allocated */
+
+
+/*
+ *  stack implemented by array
+ *
+ *  data[0] is the bottom and data[n-1] the top of a stack. The array grows by doubling its
+ *  capacity, thus pushing takes a constant time amortized; it shrinks only by stack_shrink().
+ */
 struct stack_t {
-    struct node {
-        void *data;           /* data contained in node */
-        struct node *next;    /* next node */
-    } *head;                  /* head node of stack */
+    void **data;    /* array of data; null if cap is 0 */
+    size_t n;       /* number of data in stack */
+    size_t cap;     /* capacity of array */
 };
 
 
+/*
+ *  makes the capacity of a stack at least a given value
+ */
+static void grow(stack_t *stk, size_t n)
+{
+    size_t cap;
+
+    if (n <= stk->cap)
+        return;
+
+    assert(n <= (size_t)-1 / sizeof(*stk->data));
+    cap = (stk->cap > (size_t)-1 / 2 / sizeof(*stk->data))? n: stk->cap * 2;
+    if (cap < n)
+        cap = n;
+    if (cap < MINCAP)
+        cap = MINCAP;
+    if (stk->data)
+        MEM_RESIZE(stk->data, cap*sizeof(*stk->data));
+    else
+        stk->data = MEM_ALLOC(cap*sizeof(*stk->data));
+    stk->cap = cap;
+}
+
+
 /*
  *  creates a stack
  */
@@ -26,7 +58,8 @@ stack_t *(stack_new)(void)
     stack_t *stk;
 
     MEM_NEW(stk);
-    stk->head = NULL;
+    stk->data = NULL;
+    stk->n = stk->cap = 0;
 
     return stk;
 }
@@ -38,7 +71,7 @@ stack_t *(stack_new)(void)
 int (stack_empty)(const stack_t *stk)
 {
     assert(stk);
-    return (!stk->head);
+    return (stk->n == 0);
 }
 
 
@@ -47,13 +80,11 @@ int (stack_empty)(const stack_t *stk)
  */
 void (stack_push)(stack_t *stk, void *data)
 {
-    struct node *t;
-
     assert(stk);
-    MEM_NEW(t);
-    t->data = data;
-    t->next = stk->head;
-    stk->head = t;
+
+    if (stk->n == stk->cap)
+        grow(stk, stk->n+1);
+    stk->data[stk->n++] = data;
 }
 
 
@@ -62,18 +93,10 @@ void (stack_push)(stack_t *stk, void *data)
  */
 void *(stack_pop)(stack_t *stk)
 {
-    void *data;
-    struct node *t;
-
     assert(stk);
-    assert(stk->head);
+    assert(stk->n > 0);
 
-    t = stk->head;
-    stk->head = t->next;
-    data = t->data;
-    MEM_FREE(t);
-
-    return data;
+    return stk->data[--stk->n];
 }
 
 
@@ -83,9 +106,9 @@ void *(stack_pop)(stack_t *stk)
 void *(stack_peek)(const stack_t *stk)
 {
     assert(stk);
-    assert(stk->head);
+    assert(stk->n > 0);
 
-    return (void *)((struct node *)stk->head)->data;
+    return stk->data[stk->n-1];
 }
 
 
@@ -94,16 +117,76 @@ void *(stack_peek)(const stack_t *stk)
  */
 void (stack_free)(stack_t **stk)
 {
-    struct node *t, *u;
-
     assert(stk);
     assert(*stk);
 
-    for (t = (*stk)->head; t; t = u) {
-        u = t->next;
-        MEM_FREE(t);
-    }
+    MEM_FREE((*stk)->data);
     MEM_FREE(*stk);
 }
 
+
+/*
+ *  pushes data in an array into a stack
+ */
+void (stack_pushv)(stack_t *stk, void *const *v, size_t n)
+{
+    assert(stk);
+    assert(v || n == 0);
+    assert(n <= (size_t)-1 - stk->n);
+
+    if (n == 0)
+        return;
+    grow(stk, stk->n+n);
+    memcpy(stk->data+stk->n, v, n*sizeof(*v));
+    stk->n += n;
+}
+
+
+/*
+ *  pops data from a stack into an array
+ *
+ *  v[0] gets the top-most data, which is the order stack_pop() gives them.
+ */
+size_t (stack_popv)(stack_t *stk, void **v, size_t n)
+{
+    size_t i;
+
+    assert(stk);
+    assert(v || n == 0);
+
+    if (n > stk->n)
+        n = stk->n;
+    for (i = 0; i < n; i++)
+        v[i] = stk->data[--stk->n];
+
+    return n;
+}
+
+
+/*
+ *  returns the number of data in a stack
+ */
+size_t (stack_length)(const stack_t *stk)
+{
+    assert(stk);
+    return stk->n;
+}
+
+
+/*
+ *  shrinks storage for a stack to fit data in it
+ */
+void (stack_shrink)(stack_t *stk)
+{
+    assert(stk);
+
+    if (stk->n == 0) {
+        MEM_FREE(stk->data);
+        stk->cap = 0;
+    } else if (stk->n < stk->cap) {
+        MEM_RESIZE(stk->data, stk->n*sizeof(*stk->data));
+        stk->cap = stk->n;
+    }
+}
+
 /* end of stack.c */
@@ -5,6 +5,8 @@
 #ifndef STACK_H
 #define STACK_H
 
+#include <stddef.h>    /* size_t */
+
 
 /* stack */
 typedef struct stack_t stack_t;
@@ -16,6 +18,10 @@ void stack_push(stack_t *, void *);
 void *stack_pop(stack_t *);
 void *stack_peek(const stack_t *);
 int stack_empty(const stack_t *);
+void stack_pushv(stack_t *, void *const *, size_t);
+size_t stack_popv(stack_t *, void **, size_t);
+size_t stack_length(const stack_t *);
+void stack_shrink(stack_t *);
 
 
 #endif    /* STACK_H */
@@ -7,9 +7,23 @@
 
 #include "cbl/memory.h"    /* MEM_ALLOC, MEM_FREE */
 #include "cbl/assert.h"    /* assert with exception support */
+#include "pool.h"
 #include "table.h"
 
 
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)    /* C11 atomics */
+#include <stdatomic.h>
+#define LOAD(p)     atomic_load_explicit((_Atomic int *)(p), memory_order_relaxed)
+#define STORE(p)    atomic_store_explicit((_Atomic int *)(p), 1, memory_order_relaxed)
+#elif defined(__ATOMIC_RELAXED)    /* gcc built-ins */
+#define LOAD(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STORE(p)    __atomic_store_n((p), 1, __ATOMIC_RELAXED)
+#else    /* no atomic operations; no threads run in table_pmap() */
+#define LOAD(p)     (*(p))
+#define STORE(p)    (*(p) = 1)
+#endif    /* __STDC_VERSION__ */
+
+
 /*
  *  table implemented by hash table
  *
@@ -229,6 +243,91 @@ void (table_map)(table_t *table, void apply(const void *key, void **value, void
 }
 
 
+/*
+ *  arguments to table_pmap() shared by threads
+ */
+struct pmap {
+    table_t *table;                                  /* table to traverse */
+    void (*apply)(const void *, void **, void *);    /* user-provided function */
+    void *cl;                                        /* passing-by argument to apply() */
+    unsigned stamp;                                  /* timestamp before traversal */
+    int stop;                                        /* set when modification found */
+};
+
+
+/*
+ *  checks if a table has been modified during table_pmap()
+ *
+ *  A worker cannot raise assert_exceptfail safely, thus the first thread that finds timestamp
+ *  changed sets stop to make all threads leave their ranges, and table_pmap() checks timestamp
+ *  after all threads finish.
+ */
+static int changed(struct pmap *pm)
+{
+    if (LOAD(&pm->stop))
+        return 1;
+    if (pm->table->timestamp != pm->stamp) {
+        STORE(&pm->stop);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ *  calls a user-provided function for each key-value pair in a range of buckets
+ */
+static void pmap(size_t lo, size_t hi, void *cl)
+{
+    struct pmap *pm = cl;
+    struct binding *p;
+
+    if (changed(pm))
+        return;
+    for (; lo < hi; lo++)
+        for (p = pm->table->bucket[lo]; p; p = p->link) {
+            if (changed(pm))
+                return;
+            pm->apply(p->key, &p->value, pm->cl);
+            if (changed(pm))
+                return;
+        }
+}
+
+
+/*
+ *  calls a user-provided function for each key-value pair in a table using threads
+ *
+ *  The buckets are divided among n threads including the calling one, using a thread pool that
+ *  lives during the call. Each pair is visited by only one thread, thus a callback may change the
+ *  value given to it without locking. A callback modifying the table may free a binding another
+ *  thread is visiting, thus has undefined behavior; the timestamp check is only a best effort that
+ *  catches the modification reliably when a single thread runs.
+ */
+void (table_pmap)(table_t *table, void apply(const void *key, void **value, void *cl), void *cl,
+                  int n)
+{
+    pool_t *pool;
+    struct pmap pm;
+
+    assert(table);
+    assert(apply);
+    assert(n > 0);
+
+    pm.table = table;
+    pm.apply = apply;
+    pm.cl = cl;
+    pm.stamp = table->timestamp;
+    pm.stop = 0;
+
+    pool = pool_new(n - 1);
+    pool_for(pool, 0, table->size, 0, pmap, &pm);
+    pool_free(&pool);
+    assert(table->timestamp == pm.stamp);
+}
+
+
 /*
  *  removes a key-value pair from a table
  */
@@ -19,6 +19,7 @@ void *table_put(table_t *, const void *, void *);
 void *table_get(const table_t *, const void *);
 void *table_remove(table_t *, const void *);
 void table_map(table_t *, void (const void *, void **, void *), void *);
+void table_pmap(table_t *, void (const void *, void **, void *), void *, int);
 void **table_toarray(const table_t *, void *);
 
 
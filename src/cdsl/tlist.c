@@ -0,0 +1,384 @@
+/*
+ *  tree list (cdsl)
+ */
+
+#include <limits.h>    /* LONG_MAX */
+#include <stddef.h>    /* NULL */
+#include <stdarg.h>    /* va_start, va_arg, va_end, va_list */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW0, MEM_FREE, MEM_NEW */
+#include "tlist.h"
+
+
+#define M32(x) ((x) & 0xFFFFFFFFUL)    /* truncates to 32 bits */
+
+#define SIZE(p) ((p)? (p)->size: 0)    /* number of nodes in subtree */
+
+
+/*
+ *  node of treap
+ *
+ *  The index of a node is not stored but implied by the sizes of subtrees on the path to it, which
+ *  is why inserting or removing a node does not renumber others.
+ */
+struct node {
+    struct node *left;     /* left child; preceding elements */
+    struct node *right;    /* right child; following elements */
+    long size;             /* number of nodes in subtree */
+    unsigned long prio;    /* priority; greater than those of children */
+    void *data;            /* data */
+};
+
+
+/*
+ *  tree list
+ *
+ *  A tree list is a treap with implicit keys; nodes are ordered by their positions in a list and
+ *  heap-ordered by random priorities, which keeps the expected depth logarithmic. seed is for the
+ *  random number generator that gives priorities.
+ */
+struct tlist_t {
+    struct node *root;     /* root node */
+    unsigned long seed;    /* state of random number generator */
+};
+
+
+/*
+ *  generates a random priority
+ *
+ *  Priorities need not be of high quality; a 32-bit xorshift generator suffices.
+ */
+static unsigned long rnd(tlist_t *tlist)
+{
+    unsigned long x = tlist->seed;
+
+    x = M32(x ^ (x << 13));
+    x ^= x >> 17;
+    x = M32(x ^ (x << 5));
+
+    return tlist->seed = x;
+}
+
+
+/*
+ *  splits a tree so that the first k nodes go to *pl and the others to *pr
+ */
+static void split(struct node *t, long k, struct node **pl, struct node **pr)
+{
+    if (!t) {
+        *pl = *pr = NULL;
+        return;
+    }
+
+    if (SIZE(t->left) < k) {
+        split(t->right, k - SIZE(t->left) - 1, &t->right, pr);
+        *pl = t;
+    } else {
+        split(t->left, k, pl, &t->left);
+        *pr = t;
+    }
+    t->size = SIZE(t->left) + SIZE(t->right) + 1;
+}
+
+
+/*
+ *  merges two trees so that nodes in l precede those in r
+ */
+static struct node *merge(struct node *l, struct node *r)
+{
+    if (!l)
+        return r;
+    if (!r)
+        return l;
+
+    if (l->prio > r->prio) {
+        l->size += r->size;
+        l->right = merge(l->right, r);
+        return l;
+    } else {
+        r->size += l->size;
+        r->left = merge(l, r->left);
+        return r;
+    }
+}
+
+
+/*
+ *  inserts a node to have the index i in a tree
+ *
+ *  A new node goes down only until it meets a node of lower priority, where the subtree is split
+ *  into its children.
+ */
+static struct node *insert(struct node *t, long i, struct node *p)
+{
+    if (!t)
+        return p;
+
+    if (p->prio > t->prio) {
+        split(t, i, &p->left, &p->right);
+        p->size = SIZE(p->left) + SIZE(p->right) + 1;
+        return p;
+    }
+    if (i <= SIZE(t->left))
+        t->left = insert(t->left, i, p);
+    else
+        t->right = insert(t->right, i - SIZE(t->left) - 1, p);
+    t->size++;
+
+    return t;
+}
+
+
+/*
+ *  removes a node with the index i from a tree and sets *pp to the node removed
+ */
+static struct node *erase(struct node *t, long i, struct node **pp)
+{
+    long n = SIZE(t->left);
+
+    if (i == n) {
+        *pp = t;
+        return merge(t->left, t->right);
+    }
+    if (i < n)
+        t->left = erase(t->left, i, pp);
+    else
+        t->right = erase(t->right, i-n-1, pp);
+    t->size--;
+
+    return t;
+}
+
+
+/*
+ *  locates a node with the index i
+ */
+static struct node *locate(struct node *t, long i)
+{
+    long n;
+
+    while (i != (n = SIZE(t->left)))
+        if (i < n)
+            t = t->left;
+        else {
+            i -= n + 1;
+            t = t->right;
+        }
+
+    return t;
+}
+
+
+/*
+ *  destroys a tree
+ */
+static void destroy(struct node *t)
+{
+    struct node *r;
+
+    for (; t; t = r) {
+        destroy(t->left);
+        r = t->right;
+        MEM_FREE(t);
+    }
+}
+
+
+/*
+ *  creates an empty new list
+ */
+tlist_t *(tlist_new)(void)
+{
+    tlist_t *tlist;
+
+    MEM_NEW0(tlist);
+    tlist->root = NULL;
+    tlist->seed = 2463534242UL;
+
+    return tlist;
+}
+
+
+/*
+ *  constructs a new list using a given sequence of data
+ */
+tlist_t *(tlist_list)(void *data, ...)
+{
+    va_list ap;
+    tlist_t *tlist = tlist_new();
+
+    va_start(ap, data);
+    for (; data; data = va_arg(ap, void *))
+        tlist_addtail(tlist, data);
+    va_end(ap);
+
+    return tlist;
+}
+
+
+/*
+ *  destroys a list
+ */
+void (tlist_free)(tlist_t **ptlist)
+{
+    assert(ptlist);
+    assert(*ptlist);
+
+    destroy((*ptlist)->root);
+    MEM_FREE(*ptlist);
+}
+
+
+/*
+ *  returns the length of a list
+ */
+long (tlist_length)(const tlist_t *tlist)
+{
+    assert(tlist);
+    return SIZE(tlist->root);
+}
+
+
+/*
+ *  retrieves data stored in the i-th element in a list
+ */
+void *(tlist_get)(const tlist_t *tlist, long i)
+{
+    assert(tlist);
+    assert(i >= 0 && i < SIZE(tlist->root));
+
+    return locate(tlist->root, i)->data;
+}
+
+
+/*
+ *  replaces data stored in an element with new given data
+ */
+void *(tlist_put)(tlist_t *tlist, long i, void *data)
+{
+    void *prev;
+    struct node *p;
+
+    assert(tlist);
+    assert(i >= 0 && i < SIZE(tlist->root));
+
+    p = locate(tlist->root, i);
+    prev = p->data;
+    p->data = data;
+
+    return prev;
+}
+
+
+/*
+ *  adds a new element to a specified position in a list
+ */
+void *(tlist_add)(tlist_t *tlist, long pos, void *data)
+{
+    long n;
+    struct node *p;
+
+    assert(tlist);
+
+    n = SIZE(tlist->root);
+    assert(pos >= -n);
+    assert(pos <= n+1);
+    assert(n < LONG_MAX);
+
+    /* same positions as dlist_add(); pos+(length+1) gives positive value for non-positive pos */
+    if (pos <= 0)
+        pos += n + 1;
+
+    MEM_NEW(p);
+    p->left = p->right = NULL;
+    p->size = 1;
+    p->prio = rnd(tlist);
+    p->data = data;
+    tlist->root = insert(tlist->root, pos-1, p);
+
+    return data;
+}
+
+
+/*
+ *  adds a new element before the first element
+ */
+void *(tlist_addhead)(tlist_t *tlist, void *data)
+{
+    return tlist_add(tlist, 1, data);
+}
+
+
+/*
+ *  adds an element after the last element
+ */
+void *(tlist_addtail)(tlist_t *tlist, void *data)
+{
+    return tlist_add(tlist, 0, data);
+}
+
+
+/*
+ *  removes an element with a specific index from a list
+ */
+void *(tlist_remove)(tlist_t *tlist, long i)
+{
+    void *data;
+    struct node *p;
+
+    assert(tlist);
+    assert(i >= 0 && i < SIZE(tlist->root));
+
+    tlist->root = erase(tlist->root, i, &p);
+    data = p->data;
+    MEM_FREE(p);
+
+    return data;
+}
+
+
+/*
+ *  removes the first element from a list
+ */
+void *(tlist_remhead)(tlist_t *tlist)
+{
+    assert(tlist);
+    assert(SIZE(tlist->root) > 0);
+
+    return tlist_remove(tlist, 0);
+}
+
+
+/*
+ *  removes the last element of a list
+ */
+void *(tlist_remtail)(tlist_t *tlist)
+{
+    assert(tlist);
+    assert(SIZE(tlist->root) > 0);
+
+    return tlist_remove(tlist, tlist->root->size-1);
+}
+
+
+/*
+ *  shifts a list to right or left
+ */
+void (tlist_shift)(tlist_t *tlist, long n)
+{
+    long i;
+    struct node *l, *r;
+
+    assert(tlist);
+    assert(n >= -SIZE(tlist->root));
+    assert(n <= SIZE(tlist->root));
+
+    /* index of new first element */
+    i = (n >= 0)? SIZE(tlist->root) - n: -n;
+
+    split(tlist->root, i, &l, &r);
+    tlist->root = merge(r, l);
+}
+
+/* end of tlist.c */
@@ -0,0 +1,30 @@
+/*
+ *  tree list (cdsl)
+ */
+
+#ifndef TLIST_H
+#define TLIST_H
+
+
+/* tree list */
+typedef struct tlist_t tlist_t;
+
+
+tlist_t *tlist_new(void);
+tlist_t *tlist_list(void *, ...);
+void tlist_free(tlist_t **);
+void *tlist_add(tlist_t *, long, void *);
+void *tlist_addhead(tlist_t *, void *);
+void *tlist_addtail(tlist_t *, void *);
+void *tlist_remove(tlist_t *, long);
+void *tlist_remhead(tlist_t *);
+void *tlist_remtail(tlist_t *);
+long tlist_length(const tlist_t *);
+void *tlist_get(const tlist_t *, long);
+void *tlist_put(tlist_t *, long, void *);
+void tlist_shift(tlist_t *, long);
+
+
+#endif    /* TLIST_H */
+
+/* end of tlist.h */
@@ -0,0 +1,448 @@
+/*
+ *  unrolled doubly-linked list (cdsl)
+ */
+
+#include <limits.h>    /* LONG_MAX */
+#include <stddef.h>    /* NULL */
+#include <stdarg.h>    /* va_start, va_arg, va_end, va_list */
+#include <string.h>    /* memcpy, memmove */
+
+#include "cbl/assert.h"    /* assert with exception support */
+#include "cbl/memory.h"    /* MEM_NEW0, MEM_FREE, MEM_NEW */
+#include "ulist.h"
+
+
+#define UBLOCK 32    /* max number of elements in block; 256 bytes of data with 8-byte pointers */
+
+
+/*
+ *  block of elements
+ *
+ *  Elements of a block are kept packed from data[0]; a block in a list is never empty.
+ */
+struct block {
+    struct block *prev;      /* previous block */
+    struct block *next;      /* next block */
+    int n;                   /* number of elements in block */
+    void *data[UBLOCK];      /* elements */
+};
+
+
+/*
+ *  unrolled doubly-linked list
+ *
+ *  Unlike dlist_t, blocks are not linked circularly; head->prev and tail->next are null. lastblk
+ *  and lastbase remember the last accessed block and the index of its first element; lastbase is
+ *  meaningful only when lastblk is not null.
+ */
+struct ulist_t {
+    struct block *head;       /* first block */
+    struct block *tail;       /* last block */
+    long length;              /* length of list (number of elements) */
+    long lastbase;            /* index of first element in last accessed block */
+    struct block *lastblk;    /* last accessed block */
+};
+
+
+/*
+ *  creates an empty block and links it after a block
+ *
+ *  A null pointer for after puts the new block before the head block.
+ */
+static struct block *newblk(ulist_t *ulist, struct block *after)
+{
+    struct block *b;
+
+    MEM_NEW(b);
+    b->n = 0;
+    b->prev = after;
+    b->next = (after)? after->next: ulist->head;
+    if (b->prev)
+        b->prev->next = b;
+    else
+        ulist->head = b;
+    if (b->next)
+        b->next->prev = b;
+    else
+        ulist->tail = b;
+
+    return b;
+}
+
+
+/*
+ *  unlinks and destroys a block
+ */
+static void delblk(ulist_t *ulist, struct block *b)
+{
+    if (b->prev)
+        b->prev->next = b->next;
+    else
+        ulist->head = b->next;
+    if (b->next)
+        b->next->prev = b->prev;
+    else
+        ulist->tail = b->prev;
+    MEM_FREE(b);
+}
+
+
+/*
+ *  splits a block into two so that elements from the k-th go to a new block
+ */
+static struct block *split(ulist_t *ulist, struct block *b, int k)
+{
+    struct block *q;
+
+    q = newblk(ulist, b);
+    q->n = b->n - k;
+    memcpy(q->data, b->data+k, q->n*sizeof(*b->data));
+    b->n = k;
+
+    return q;
+}
+
+
+/*
+ *  locates a block containing the i-th element
+ *
+ *  locate() starts from the head, the tail or the last accessed block whichever is closer to the
+ *  i-th element and skips whole blocks on the way.
+ */
+static struct block *locate(ulist_t *ulist, long i, long *pbase)
+{
+    long base, d;
+    struct block *b;
+
+    if ((b = ulist->lastblk) != NULL && i >= ulist->lastbase && i < ulist->lastbase + b->n) {
+        *pbase = ulist->lastbase;
+        return b;
+    }
+
+    if (i < ulist->length/2)
+        b = ulist->head, base = 0, d = i;
+    else
+        b = ulist->tail, base = ulist->length - b->n, d = ulist->length - i;
+    if (ulist->lastblk) {
+        long e = (i < ulist->lastbase)? ulist->lastbase - i: i - ulist->lastbase - ulist->lastblk->n;
+        if (e < d)
+            b = ulist->lastblk, base = ulist->lastbase;
+    }
+
+    while (i < base) {
+        b = b->prev;
+        base -= b->n;
+    }
+    while (i >= base + b->n) {
+        base += b->n;
+        b = b->next;
+    }
+
+    ulist->lastblk = b;
+    ulist->lastbase = base;
+    *pbase = base;
+
+    return b;
+}
+
+
+/*
+ *  inserts an element to have the index i
+ *
+ *  A full block is split in half unless an element goes to the end of a block whose next one has
+ *  room. Adding to the head or the tail of a list whose end block is full just starts a new block
+ *  to keep blocks full.
+ */
+static void insert(ulist_t *ulist, long i, void *data)
+{
+    int k;
+    long base;
+    struct block *b;
+
+    if (ulist->length == 0)
+        b = newblk(ulist, NULL), base = 0;
+    else if (i == ulist->length) {
+        b = ulist->tail;
+        base = ulist->length - b->n;
+        if (b->n == UBLOCK)
+            b = newblk(ulist, b), base = ulist->length;
+    } else if (i == 0 && ulist->head->n == UBLOCK)
+        b = newblk(ulist, NULL), base = 0;
+    else {
+        b = locate(ulist, i, &base);
+        if (b->n == UBLOCK) {
+            if (i == base && b->prev && b->prev->n < UBLOCK) {
+                b = b->prev;
+                base -= b->n;
+            } else {
+                split(ulist, b, UBLOCK/2);
+                if (i - base > UBLOCK/2) {
+                    base += UBLOCK/2;
+                    b = b->next;
+                }
+            }
+        }
+    }
+
+    k = i - base;
+    memmove(b->data+k+1, b->data+k, (b->n-k)*sizeof(*b->data));
+    b->data[k] = data;
+    b->n++;
+    ulist->length++;
+
+    ulist->lastblk = b;
+    ulist->lastbase = base;
+}
+
+
+/*
+ *  creates an empty new list
+ */
+ulist_t *(ulist_new)(void)
+{
+    ulist_t *ulist;
+
+    MEM_NEW0(ulist);
+    ulist->head = ulist->tail = NULL;
+    ulist->lastblk = NULL;
+
+    return ulist;
+}
+
+
+/*
+ *  constructs a new list using a given sequence of data
+ */
+ulist_t *(ulist_list)(void *data, ...)
+{
+    va_list ap;
+    ulist_t *ulist = ulist_new();
+
+    va_start(ap, data);
+    for (; data; data = va_arg(ap, void *))
+        ulist_addtail(ulist, data);
+    va_end(ap);
+
+    return ulist;
+}
+
+
+/*
+ *  destroys a list
+ */
+void (ulist_free)(ulist_t **pulist)
+{
+    struct block *b,    /* block to be freed */
+                 *q;    /* next to block freed */
+
+    assert(pulist);
+    assert(*pulist);
+
+    for (b = (*pulist)->head; b; b = q) {
+        q = b->next;
+        MEM_FREE(b);
+    }
+    MEM_FREE(*pulist);
+}
+
+
+/*
+ *  returns the length of a list
+ */
+long (ulist_length)(const ulist_t *ulist)
+{
+    assert(ulist);
+    return ulist->length;
+}
+
+
+/*
+ *  retrieves data stored in the i-th element in a list
+ */
+void *(ulist_get)(ulist_t *ulist, long i)
+{
+    long base;
+    struct block *b;
+
+    assert(ulist);
+    assert(i >= 0 && i < ulist->length);
+
+    b = locate(ulist, i, &base);
+
+    return b->data[i-base];
+}
+
+
+/*
+ *  replaces data stored in an element with new given data
+ */
+void *(ulist_put)(ulist_t *ulist, long i, void *data)
+{
+    long base;
+    void *prev;
+    struct block *b;
+
+    assert(ulist);
+    assert(i >= 0 && i < ulist->length);
+
+    b = locate(ulist, i, &base);
+    prev = b->data[i-base];
+    b->data[i-base] = data;
+
+    return prev;
+}
+
+
+/*
+ *  adds an element after the last element
+ */
+void *(ulist_addtail)(ulist_t *ulist, void *data)
+{
+    assert(ulist);
+    assert(ulist->length < LONG_MAX);
+
+    insert(ulist, ulist->length, data);
+
+    return data;
+}
+
+
+/*
+ *  adds a new element before the first element
+ */
+void *(ulist_addhead)(ulist_t *ulist, void *data)
+{
+    assert(ulist);
+    assert(ulist->length < LONG_MAX);
+
+    insert(ulist, 0, data);
+
+    return data;
+}
+
+
+/*
+ *  adds a new element to a specified position in a list
+ */
+void *(ulist_add)(ulist_t *ulist, long pos, void *data)
+{
+    assert(ulist);
+    assert(pos >= -ulist->length);
+    assert(pos <= ulist->length+1);
+    assert(ulist->length < LONG_MAX);
+
+    /* same positions as dlist_add(); pos+(length+1) gives positive value for non-positive pos */
+    if (pos <= 0)
+        pos += ulist->length + 1;
+    insert(ulist, pos-1, data);
+
+    return data;
+}
+
+
+/*
+ *  removes an element with a specific index from a list
+ *
+ *  A block gets merged with its neighbor when both together fill no more than half a block, which
+ *  keeps blocks from getting sparse after many removals.
+ */
+void *(ulist_remove)(ulist_t *ulist, long i)
+{
+    int k;
+    long base;
+    void *data;
+    struct block *b, *q;
+
+    assert(ulist);
+    assert(ulist->length > 0);
+    assert(i >= 0 && i < ulist->length);
+
+    b = locate(ulist, i, &base);
+    k = i - base;
+    data = b->data[k];
+    memmove(b->data+k, b->data+k+1, (b->n-k-1)*sizeof(*b->data));
+    b->n--;
+    ulist->length--;
+
+    if (b->n == 0) {
+        q = b->next;
+        delblk(ulist, b);
+        b = q;    /* next block if any starts at base */
+    } else if ((q = b->next) != NULL && b->n + q->n <= UBLOCK/2) {
+        memcpy(b->data+b->n, q->data, q->n*sizeof(*q->data));
+        b->n += q->n;
+        delblk(ulist, q);
+    } else if ((q = b->prev) != NULL && q->n + b->n <= UBLOCK/2) {
+        memcpy(q->data+q->n, b->data, b->n*sizeof(*b->data));
+        q->n += b->n;
+        base -= q->n - b->n;
+        delblk(ulist, b);
+        b = q;
+    }
+
+    ulist->lastblk = b;
+    ulist->lastbase = base;
+
+    return data;
+}
+
+
+/*
+ *  removes the last element of a list
+ */
+void *(ulist_remtail)(ulist_t *ulist)
+{
+    assert(ulist);
+    assert(ulist->length > 0);
+
+    return ulist_remove(ulist, ulist->length-1);
+}
+
+
+/*
+ *  removes the first element from a list
+ */
+void *(ulist_remhead)(ulist_t *ulist)
+{
+    assert(ulist);
+    assert(ulist->length > 0);
+
+    return ulist_remove(ulist, 0);
+}
+
+
+/*
+ *  shifts a list to right or left
+ *
+ *  The block containing the new first element is split there if necessary, and the chain of blocks
+ *  from it is moved before the head block; no element is copied except for the split.
+ */
+void (ulist_shift)(ulist_t *ulist, long n)
+{
+    long i, base;
+    struct block *b;
+
+    assert(ulist);
+    assert(n >= -ulist->length);
+    assert(n <= ulist->length);
+
+    /* index of new first element */
+    i = (n >= 0)? ulist->length - n: -n;
+    if (i == 0 || i == ulist->length)
+        return;
+
+    b = locate(ulist, i, &base);
+    if (i > base)
+        b = split(ulist, b, i-base);
+
+    ulist->tail->next = ulist->head;
+    ulist->head->prev = ulist->tail;
+    ulist->tail = b->prev;
+    ulist->tail->next = NULL;
+    b->prev = NULL;
+    ulist->head = b;
+
+    ulist->lastblk = NULL;
+}
+
+/* end of ulist.c */
@@ -0,0 +1,30 @@
+/*
+ *  unrolled doubly-linked list (cdsl)
+ */
+
+#ifndef ULIST_H
+#define ULIST_H
+
+
+/* unrolled doubly-linked list */
+typedef struct ulist_t ulist_t;
+
+
+ulist_t *ulist_new(void);
+ulist_t *ulist_list(void *, ...);
+void ulist_free(ulist_t **);
+void *ulist_add(ulist_t *, long, void *);
+void *ulist_addhead(ulist_t *, void *);
+void *ulist_addtail(ulist_t *, void *);
+void *ulist_remove(ulist_t *, long);
+void *ulist_remhead(ulist_t *);
+void *ulist_remtail(ulist_t *);
+long ulist_length(const ulist_t *);
+void *ulist_get(ulist_t *, long);
+void *ulist_put(ulist_t *, long, void *);
+void ulist_shift(ulist_t *, long);
+
+
+#endif    /* ULIST_H */
+
+/* end of ulist.h */